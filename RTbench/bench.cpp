@@ -0,0 +1,99 @@
+#include "bench.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+struct Benchmark {
+    const char *name;
+    BenchFunction f;
+};
+
+static std::vector<Benchmark>& benchmarks() {
+    static std::vector<Benchmark> all;
+    return all;
+}
+
+int register_benchmark(const char *name, BenchFunction f) {
+    benchmarks().push_back({name, f});
+    return (int) benchmarks().size();
+}
+
+const std::vector<Ray>& bench_rays() {
+    static const std::vector<Ray> rays = [] {
+        std::mt19937 gen(BENCH_SEED);
+        std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+        std::vector<Ray> rays;
+        while (rays.size() < BENCH_N_RAYS) {
+            const Tuple d = Vector(dist(gen), dist(gen), dist(gen));
+            if (d.magnitude() < 0.1f || d.magnitude() > 1.0f)
+                continue;
+            const Tuple origin = Point(0, 0, 0) + d.normalize() * 5.0f;
+            const Tuple target = Point(dist(gen), dist(gen), dist(gen));
+            rays.push_back(Ray(origin, (target - origin).normalize()));
+        }
+        return rays;
+    }();
+    return rays;
+}
+
+const std::vector<Tuple>& bench_points() {
+    static const std::vector<Tuple> points = [] {
+        std::mt19937 gen(BENCH_SEED + 1);
+        std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+        std::vector<Tuple> points;
+        for (uint32_t i = 0; i < BENCH_N_RAYS; i++)
+            points.push_back(Point(dist(gen), dist(gen), dist(gen)));
+        return points;
+    }();
+    return points;
+}
+
+static double seconds(BenchFunction f, uint64_t n) {
+    const auto start = std::chrono::steady_clock::now();
+    f(n);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Doubles the number of operations until a run takes 50 ms, then takes the median of the repetitions
+static double ns_per_op(BenchFunction f, int repetitions) {
+    uint64_t n = 1;
+    while (seconds(f, n) < 0.05)
+        n *= 2;
+    std::vector<double> times;
+    for (int i = 0; i < repetitions; i++)
+        times.push_back(seconds(f, n) * 1e9 / n);
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+// Usage: RTbench [-r repetitions] [filter...], runs the benchmarks whose name contains one of the filters
+int main(int argc, const char *argv[]) {
+    int repetitions = 5;
+    std::vector<std::string> filters;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+            repetitions = std::max(1, std::atoi(argv[++i]));
+        else
+            filters.push_back(argv[i]);
+    }
+
+    std::cout << std::left << std::setw(32) << "benchmark" << std::right << std::setw(12) << "ns/op"
+              << std::setw(16) << "ops/sec" << std::endl;
+    for (const auto &b : benchmarks()) {
+        const std::string name = b.name;
+        if (!filters.empty() && std::none_of(filters.begin(), filters.end(), [&](const std::string &f) {
+            return name.find(f) != std::string::npos;
+        }))
+            continue;
+        const double ns = ns_per_op(b.f, repetitions);
+        std::cout << std::left << std::setw(32) << name << std::right << std::fixed
+                  << std::setw(12) << std::setprecision(2) << ns
+                  << std::setw(16) << std::setprecision(0) << 1e9 / ns << std::endl;
+    }
+    return 0;
+}
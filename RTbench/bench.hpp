@@ -0,0 +1,35 @@
+#ifndef bench_hpp
+#define bench_hpp
+
+#include "Ray.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Micro-benchmarks. A benchmark is a function doing n operations, the harness picks n such that a run
+// takes long enough to time, repeats the run and reports the median time per operation.
+// Inputs are generated from a fixed seed, so every run measures the same work. For the intersection
+// benchmarks an operation is one ray, so ops/sec reads as rays/sec.
+
+constexpr uint32_t BENCH_SEED = 1234;
+constexpr uint32_t BENCH_N_RAYS = 1024;
+
+using BenchFunction = void (*)(uint64_t n);
+
+int register_benchmark(const char *name, BenchFunction f);
+
+#define BENCHMARK(name, f) static const int f##_registered = register_benchmark(name, f)
+
+// Keeps the compiler from removing the computation of a value that is not used otherwise
+template <typename T>
+inline void keep(const T &value) {
+    asm volatile("" : : "r"(&value) : "memory");
+}
+
+// Rays starting at distance 5 from the origin aimed at random points in the unit cube, most of them hit
+// a unit shape. The number of rays is a power of two, index them with i & (BENCH_N_RAYS - 1).
+const std::vector<Ray>& bench_rays();
+// Random points in the unit cube
+const std::vector<Tuple>& bench_points();
+
+#endif /* bench_hpp */
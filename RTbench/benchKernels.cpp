@@ -0,0 +1,177 @@
+#include "bench.hpp"
+#include "Bounds.hpp"
+#include "Matrix.hpp"
+#include "Transformations.hpp"
+#include "Sphere.hpp"
+#include "Light.hpp"
+#include "PointLight.hpp"
+#include "Pattern.hpp"
+#include "PatternProgram.hpp"
+
+static void bounds_intersects(uint64_t n) {
+    const Bounds box = Bounds(Point(-0.5f, -0.5f, -0.5f), Point(0.5f, 0.5f, 0.5f));
+    const std::vector<Ray> &rays = bench_rays();
+    for (uint64_t i = 0; i < n; i++)
+        keep(box.intersects(rays[i & (BENCH_N_RAYS - 1)]));
+}
+BENCHMARK("bounds/intersects", bounds_intersects);
+
+static void bounds_interval(uint64_t n) {
+    const Bounds box = Bounds(Point(-0.5f, -0.5f, -0.5f), Point(0.5f, 0.5f, 0.5f));
+    const std::vector<Ray> &rays = bench_rays();
+    float t0, t1;
+    for (uint64_t i = 0; i < n; i++) {
+        keep(box.intersects(rays[i & (BENCH_N_RAYS - 1)], &t0, &t1));
+        keep(t0);
+    }
+}
+BENCHMARK("bounds/intersects_interval", bounds_interval);
+
+// A handful of different invertible transforms
+static const std::vector<Matrix<4, 4>>& transforms() {
+    static const std::vector<Matrix<4, 4>> ms = [] {
+        std::vector<Matrix<4, 4>> ms;
+        for (const Tuple &p : bench_points()) {
+            ms.push_back(Transform::translation(p[0], p[1], p[2]) *
+                         Transform::rotation_y(p[0]) *
+                         Transform::scaling(1.5f + p[1], 1.5f + p[2], 1.5f + p[0]));
+            if (ms.size() == 16)
+                break;
+        }
+        return ms;
+    }();
+    return ms;
+}
+
+static void matrix_inverse(uint64_t n) {
+    const std::vector<Matrix<4, 4>> &ms = transforms();
+    for (uint64_t i = 0; i < n; i++)
+        keep(ms[i & 15].inverse());
+}
+BENCHMARK("matrix/inverse", matrix_inverse);
+
+static void matrix_multiply(uint64_t n) {
+    const std::vector<Matrix<4, 4>> &ms = transforms();
+    for (uint64_t i = 0; i < n; i++)
+        keep(ms[i & 15] * ms[(i + 1) & 15]);
+}
+BENCHMARK("matrix/multiply", matrix_multiply);
+
+static void matrix_tuple(uint64_t n) {
+    const std::vector<Matrix<4, 4>> &ms = transforms();
+    const std::vector<Tuple> &ps = bench_points();
+    for (uint64_t i = 0; i < n; i++)
+        keep(ms[i & 15] * ps[i & (BENCH_N_RAYS - 1)]);
+}
+BENCHMARK("matrix/multiply_tuple", matrix_tuple);
+
+static void lighting(uint64_t n) {
+    static const ShapePtr s = std::make_shared<Sphere>();
+    static const LightPtr light = std::make_shared<PointLight>(Point(-10, 10, -10), Color(1, 1, 1));
+    const std::vector<Tuple> &ps = bench_points();
+    const Tuple eyev = Vector(0, 0, -1);
+    for (uint64_t i = 0; i < n; i++) {
+        const Tuple &p = ps[i & (BENCH_N_RAYS - 1)];
+        const Tuple normalv = Vector(p[0], p[1], p[2]).normalize();
+        keep(Lighting(s->get_material(), s, light, p, eyev, normalv));
+    }
+}
+BENCHMARK("shading/lighting", lighting);
+
+// Computations for the hits of rays on a sphere, with the list of all intersections along the ray
+static void prepare_computations(uint64_t n) {
+    static const ShapePtr s = std::make_shared<Sphere>();
+    static const std::vector<std::vector<Intersection>> all_xs = [] {
+        std::vector<std::vector<Intersection>> all_xs;
+        for (const Ray &r : bench_rays()) {
+            std::vector<Intersection> xs;
+            r.intersect(s, xs);
+            if (xs.empty())
+                xs.push_back(Intersection(1.0f, s));
+            all_xs.push_back(xs);
+        }
+        return all_xs;
+    }();
+    const std::vector<Ray> &rays = bench_rays();
+    for (uint64_t i = 0; i < n; i++) {
+        const std::vector<Intersection> &xs = all_xs[i & (BENCH_N_RAYS - 1)];
+        keep(rays[i & (BENCH_N_RAYS - 1)].prepare_computations(xs.front(), xs));
+    }
+}
+BENCHMARK("shading/prepare_computations", prepare_computations);
+
+static void pattern(const Pattern &pattern, uint64_t n) {
+    const std::vector<Tuple> &ps = bench_points();
+    for (uint64_t i = 0; i < n; i++)
+        keep(pattern.color_at(ps[i & (BENCH_N_RAYS - 1)]));
+}
+
+static void stripes(uint64_t n) {
+    pattern(PatternStripe(Color::white(), Color::black()), n);
+}
+BENCHMARK("pattern/stripe", stripes);
+
+static void checkers(uint64_t n) {
+    pattern(PatternCheckers(Color::white(), Color::black()), n);
+}
+BENCHMARK("pattern/checkers", checkers);
+
+static void rings(uint64_t n) {
+    pattern(PatternRing(Color::white(), Color::black()), n);
+}
+BENCHMARK("pattern/ring", rings);
+
+static void gradient(uint64_t n) {
+    pattern(PatternGradient(Color::white(), Color::black()), n);
+}
+BENCHMARK("pattern/gradient", gradient);
+
+static void fbm4(uint64_t n) {
+    pattern(PatternFbm(Color::white(), Color::black(), 4), n);
+}
+BENCHMARK("pattern/fbm_4", fbm4);
+
+static void fbm8(uint64_t n) {
+    pattern(PatternFbm(Color::white(), Color::black(), 8), n);
+}
+BENCHMARK("pattern/fbm_8", fbm8);
+
+static void marble(uint64_t n) {
+    pattern(PatternMarble(Color::white(), Color::black()), n);
+}
+BENCHMARK("pattern/marble", marble);
+
+static void wood(uint64_t n) {
+    pattern(PatternWood(Color::white(), Color::black()), n);
+}
+BENCHMARK("pattern/wood", wood);
+
+// Patterns nested in a pattern, each level applies its own transform
+static PatternPtr nested_pattern() {
+    const auto stripes = std::make_shared<PatternStripe>(Color::white(), Color::black());
+    stripes->set_transform(Transform::scaling(0.25f, 0.25f, 0.25f) * Transform::rotation_y(M_PI / 4.0f));
+    const auto rings = std::make_shared<PatternRing>(Color(1, 0, 0), Color(0, 0, 1));
+    return std::make_shared<PatternCheckers>(stripes, rings);
+}
+
+static void nested(uint64_t n) {
+    pattern(*nested_pattern(), n);
+}
+BENCHMARK("pattern/nested", nested);
+
+static void nested_program(uint64_t n) {
+    pattern(PatternProgram(nested_pattern()), n);
+}
+BENCHMARK("pattern/nested_program", nested_program);
+
+static void nested_program_batch(uint64_t n) {
+    const PatternProgram program(nested_pattern());
+    const std::vector<Tuple> &ps = bench_points();
+    std::vector<Color> out(BENCH_N_RAYS);
+    for (uint64_t i = 0; i < n; i += BENCH_N_RAYS) {
+        const size_t count = std::min<uint64_t>(BENCH_N_RAYS, n - i);
+        program.colors_at(ps.data(), out.data(), count);
+        keep(out[count - 1]);
+    }
+}
+BENCHMARK("pattern/nested_program_batch", nested_program_batch);
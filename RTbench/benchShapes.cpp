@@ -0,0 +1,73 @@
+#include "bench.hpp"
+#include "Sphere.hpp"
+#include "Cube.hpp"
+#include "Cylinder.hpp"
+#include "Cone.hpp"
+#include "Triangle.hpp"
+#include "SmoothTriangle.hpp"
+#include "Transformations.hpp"
+
+// Intersects the shape in object space, the transform is benchmarked with the matrices
+static void intersect_shape(const ShapePtr &s, uint64_t n) {
+    const std::vector<Ray> &rays = bench_rays();
+    std::vector<Intersection> xs;
+    for (uint64_t i = 0; i < n; i++) {
+        xs.clear();
+        s->intersect(rays[i & (BENCH_N_RAYS - 1)], xs);
+        keep(xs.size());
+    }
+}
+
+static void sphere(uint64_t n) {
+    static const ShapePtr s = std::make_shared<Sphere>();
+    intersect_shape(s, n);
+}
+BENCHMARK("intersect/sphere", sphere);
+
+static void cube(uint64_t n) {
+    static const ShapePtr s = std::make_shared<Cube>();
+    intersect_shape(s, n);
+}
+BENCHMARK("intersect/cube", cube);
+
+static void cylinder(uint64_t n) {
+    static const ShapePtr s = std::make_shared<Cylinder>(-1.0f, 1.0f, true);
+    intersect_shape(s, n);
+}
+BENCHMARK("intersect/cylinder", cylinder);
+
+static void cone(uint64_t n) {
+    static const ShapePtr s = std::make_shared<Cone>(-1.0f, 1.0f, true);
+    intersect_shape(s, n);
+}
+BENCHMARK("intersect/cone", cone);
+
+static void triangle(uint64_t n) {
+    static const ShapePtr s = std::make_shared<Triangle>(Point(0, 1, 0), Point(-1, -1, 0), Point(1, -1, 0));
+    intersect_shape(s, n);
+}
+BENCHMARK("intersect/triangle", triangle);
+
+static void smooth_triangle(uint64_t n) {
+    static const ShapePtr s = std::make_shared<SmoothTriangle>(Point(0, 1, 0), Point(-1, -1, 0), Point(1, -1, 0),
+                                                               Vector(0, 1, -1), Vector(-1, -1, -1), Vector(1, -1, -1));
+    intersect_shape(s, n);
+}
+BENCHMARK("intersect/smooth_triangle", smooth_triangle);
+
+// The full path through Ray::intersect, which transforms the ray first
+static void sphere_transformed(uint64_t n) {
+    static const ShapePtr s = [] {
+        const ShapePtr s = std::make_shared<Sphere>();
+        s->set_transform(Transform::translation(0.1f, 0.2f, 0.3f) * Transform::scaling(0.8f, 0.9f, 1.0f));
+        return s;
+    }();
+    const std::vector<Ray> &rays = bench_rays();
+    std::vector<Intersection> xs;
+    for (uint64_t i = 0; i < n; i++) {
+        xs.clear();
+        rays[i & (BENCH_N_RAYS - 1)].intersect(s, xs);
+        keep(xs.size());
+    }
+}
+BENCHMARK("intersect/sphere_transformed", sphere_transformed);
@@ -0,0 +1,195 @@
+#include "scenes.hpp"
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <thread>
+
+// End to end benchmarks: renders every scene at a fixed resolution with 1, 2, 4, ... up to the maximum
+// number of threads and writes the results as JSON, one result per line. Given a baseline written by an
+// earlier run, the render times of the same scene and number of threads are compared to it. The header of
+// the results records the number of cores, runs beyond it share them and do not show scaling.
+//
+// Every run builds and renders its scene in a child process, so the peak RSS is that of the run alone. The
+// BVHs are built on as many threads as the frame is rendered on.
+// rays_per_sec only counts camera rays, with or without RT_STATS, so results of both builds compare.
+//
+// Usage: RTscenes [-t threads] [-w width] [-h height] [-s samples] [-o results.json] [-b baseline.json] [scene...]
+
+struct Result {
+    std::string scene;
+    unsigned threads;
+    double build_ms;
+    double wall_ms;
+    double rays_per_sec;
+    long peak_rss_kb;
+};
+
+// Peak resident set size of the calling process
+static long peak_rss_kb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+static std::string to_json(const Result &r) {
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(3)
+       << "{\"scene\": \"" << r.scene << "\", \"threads\": " << r.threads
+       << ", \"build_ms\": " << r.build_ms << ", \"wall_ms\": " << r.wall_ms
+       << ", \"rays_per_sec\": " << std::setprecision(0) << r.rays_per_sec
+       << ", \"peak_rss_kb\": " << r.peak_rss_kb << "}";
+    return os.str();
+}
+
+// Only reads back what to_json writes
+static double json_number(const std::string &line, const std::string &key) {
+    const size_t pos = line.find("\"" + key + "\": ");
+    return pos == std::string::npos ? 0.0 : std::atof(line.c_str() + pos + key.size() + 4);
+}
+
+static std::string json_string(const std::string &line, const std::string &key) {
+    const size_t pos = line.find("\"" + key + "\": \"");
+    if (pos == std::string::npos)
+        return "";
+    const size_t begin = pos + key.size() + 5;
+    return line.substr(begin, line.find('"', begin) - begin);
+}
+
+static Result from_json(const std::string &line) {
+    return {json_string(line, "scene"), (unsigned) json_number(line, "threads"), json_number(line, "build_ms"),
+            json_number(line, "wall_ms"), json_number(line, "rays_per_sec"), (long) json_number(line, "peak_rss_kb")};
+}
+
+// Builds the scene and renders it in a child process, which sends its result back as a line of JSON
+static bool run(const SceneEntry &entry, unsigned threads, uint32_t width, uint32_t height, uint32_t samples,
+                Result &r) {
+    int fds[2];
+    if (pipe(fds) != 0)
+        return false;
+    std::cout.flush();
+    const pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        const Scene scene = entry.make(entry.size, threads);
+        Camera camera = Camera(width, height, M_PI / 3.0f);
+        camera.set_transform(scene.view);
+        const auto start = std::chrono::steady_clock::now();
+        camera.render(scene.world, samples, threads);
+        const double wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        // The render loop takes samples + 1 rays per pixel when supersampling
+        const double camera_rays = (double) width * height * (samples <= 1 ? 1 : samples + 1);
+        const std::string line = to_json({scene.name, threads, scene.build_ms, wall_ms,
+                                          camera_rays / (wall_ms / 1000.0), peak_rss_kb()}) + "\n";
+        const bool written = write(fds[1], line.data(), line.size()) == (ssize_t) line.size();
+        close(fds[1]);
+        _exit(written ? 0 : 1);
+    }
+    close(fds[1]);
+    std::string line;
+    char buffer[256];
+    ssize_t n;
+    while ((n = read(fds[0], buffer, sizeof(buffer))) > 0)
+        line.append(buffer, n);
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || line.empty())
+        return false;
+    r = from_json(line);
+    return true;
+}
+
+static std::map<std::pair<std::string, unsigned>, double> load_baseline(const std::string &fname) {
+    std::map<std::pair<std::string, unsigned>, double> wall_ms;
+    std::ifstream is(fname);
+    std::string line;
+    while (std::getline(is, line)) {
+        const std::string scene = json_string(line, "scene");
+        if (!scene.empty())
+            wall_ms[{scene, (unsigned) json_number(line, "threads")}] = json_number(line, "wall_ms");
+    }
+    return wall_ms;
+}
+
+int main(int argc, const char *argv[]) {
+    unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+    uint32_t width = 160, height = 120, samples = 1;
+    std::string out_fname, baseline_fname;
+    std::vector<std::string> filters;
+    for (int i = 1; i < argc; i++) {
+        const bool has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "-t") == 0 && has_value)
+            max_threads = std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "-w") == 0 && has_value)
+            width = std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "-h") == 0 && has_value)
+            height = std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "-s") == 0 && has_value)
+            samples = std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "-o") == 0 && has_value)
+            out_fname = argv[++i];
+        else if (std::strcmp(argv[i], "-b") == 0 && has_value)
+            baseline_fname = argv[++i];
+        else
+            filters.push_back(argv[i]);
+    }
+    std::vector<unsigned> thread_counts;
+    for (unsigned t = 1; t < max_threads; t *= 2)
+        thread_counts.push_back(t);
+    thread_counts.push_back(max_threads);
+
+    const auto baseline = baseline_fname.empty() ? decltype(load_baseline("")){} : load_baseline(baseline_fname);
+
+    std::vector<Result> results;
+    for (const auto &entry : scenes()) {
+        if (!filters.empty() && std::find(filters.begin(), filters.end(), entry.name) == filters.end())
+            continue;
+        for (unsigned threads : thread_counts) {
+            Result r;
+            if (!run(entry, threads, width, height, samples, r)) {
+                std::cerr << entry.name << " failed on " << threads << " threads" << std::endl;
+                return 1;
+            }
+            results.push_back(r);
+
+            std::cout << std::left << std::setw(14) << r.scene << std::right << std::setw(4) << threads << " threads"
+                      << std::fixed << std::setprecision(1) << std::setw(12) << r.wall_ms << " ms"
+                      << std::setprecision(0) << std::setw(14) << r.rays_per_sec << " rays/s"
+                      << std::setw(10) << r.peak_rss_kb << " kB";
+            const auto it = baseline.find({r.scene, threads});
+            if (it != baseline.end() && it->second > 0.0)
+                std::cout << std::setprecision(2) << std::setw(10) << r.wall_ms / it->second << "x baseline";
+            std::cout << std::endl;
+        }
+    }
+
+    if (!out_fname.empty()) {
+        std::ofstream os(out_fname);
+        os << "{\"width\": " << width << ", \"height\": " << height << ", \"samples\": " << samples
+           << ", \"cores\": " << std::thread::hardware_concurrency() << ", \"rays\": \"camera\",\n";
+        os << " \"results\": [\n";
+        for (size_t i = 0; i < results.size(); i++)
+            os << "  " << to_json(results[i]) << (i + 1 < results.size() ? ",\n" : "\n");
+        os << " ]}\n";
+    }
+    return 0;
+}
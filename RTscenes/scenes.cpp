@@ -0,0 +1,169 @@
+#include "scenes.hpp"
+#include "Sphere.hpp"
+#include "Cube.hpp"
+#include "Plane.hpp"
+#include "CSG.hpp"
+#include "Group.hpp"
+#include "MengerSponge.hpp"
+#include "ObjParser.hpp"
+#include "PointLight.hpp"
+#include "Pattern.hpp"
+#include "Transformations.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <sstream>
+
+using Clock = std::chrono::steady_clock;
+
+static double ms_since(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static ShapePtr checkered_floor() {
+    const ShapePtr floor = std::make_shared<Plane>();
+    floor->mod_material().set_pattern(std::make_shared<PatternCheckers>(Color(0.9f, 0.9f, 0.9f), Color(0.2f, 0.2f, 0.2f)));
+    floor->mod_material().set_specular(0.0f);
+    return floor;
+}
+
+// The scene of the picture in the README: a cube with a sphere cut out above a reflective floor
+static Scene csg_reflect(int, unsigned) {
+    Scene scene = {"csg_reflect", World(), Transform::view_transform(Point(0, 2.5f, -6), Point(0, 0.8f, 0), Vector(0, 1, 0)), 0.0};
+    const ShapePtr floor = checkered_floor();
+    floor->mod_material().set_reflective(0.4f);
+    scene.world.insert(floor);
+
+    const ShapePtr cube = std::make_shared<Cube>();
+    cube->mod_material().set_color(Color(0.8f, 0.2f, 0.2f));
+    const ShapePtr sphere = std::make_shared<Sphere>();
+    sphere->set_transform(Transform::scaling(1.3f, 1.3f, 1.3f));
+    sphere->mod_material().set_color(Color(0.2f, 0.2f, 0.8f));
+    const ShapePtr csg = CSG::create(std::make_shared<csgDifferenceOperator>(), cube, sphere);
+    csg->set_transform(Transform::translation(0, 1, 0) * Transform::rotation_y(M_PI / 6.0f));
+    scene.world.insert(csg);
+
+    for (int i = 0; i < 2; i++) {
+        const ShapePtr ball = std::make_shared<Sphere>();
+        ball->set_transform(Transform::translation(-2.5f + 5.0f * i, 0.6f, 0.5f) * Transform::scaling(0.6f, 0.6f, 0.6f));
+        ball->mod_material().set_reflective(0.6f);
+        ball->mod_material().set_color(Color(0.1f, 0.1f, 0.1f));
+        scene.world.insert(ball);
+    }
+    scene.world.insert(std::make_shared<PointLight>(Point(-5, 8, -8), Color(1, 1, 1)));
+    return scene;
+}
+
+static Scene sponge(int level, unsigned) {
+    Scene scene = {"sponge", World(), Transform::view_transform(Point(2.0f, 2.5f, -3.5f), Point(0.5f, 0.5f, 0.5f), Vector(0, 1, 0)), 0.0};
+    const auto start = Clock::now();
+    const ShapePtr sponge = MengerSponge(level);
+    scene.build_ms = ms_since(start);
+    scene.world.insert(sponge);
+    scene.world.insert(checkered_floor());
+    scene.world.insert(std::make_shared<PointLight>(Point(-5, 8, -8), Color(1, 1, 1)));
+    return scene;
+}
+
+// A torus with rings * 2 * rings vertices, written as OBJ and read back like a mesh from a file
+static std::string torus_obj(int rings) {
+    const int segments = 2 * rings;
+    std::ostringstream obj;
+    for (int i = 0; i < segments; i++) {
+        const float a = 2.0f * M_PI * i / segments;
+        for (int j = 0; j < rings; j++) {
+            const float b = 2.0f * M_PI * j / rings;
+            const float r = 1.0f + 0.35f * std::cos(b);
+            obj << "v " << r * std::cos(a) << " " << 0.35f * std::sin(b) << " " << r * std::sin(a) << "\n";
+        }
+    }
+    for (int i = 0; i < segments; i++) {
+        for (int j = 0; j < rings; j++) {
+            const int v00 = i * rings + j + 1;
+            const int v01 = i * rings + (j + 1) % rings + 1;
+            const int v10 = (i + 1) % segments * rings + j + 1;
+            const int v11 = (i + 1) % segments * rings + (j + 1) % rings + 1;
+            obj << "f " << v00 << " " << v10 << " " << v11 << "\n";
+            obj << "f " << v00 << " " << v11 << " " << v01 << "\n";
+        }
+    }
+    return obj.str();
+}
+
+static Scene mesh(int rings, unsigned n_threads) {
+    Scene scene = {"mesh", World(), Transform::view_transform(Point(0, 2.5f, -3.5f), Point(0, 0, 0), Vector(0, 1, 0)), 0.0};
+    ObjParser parser;
+    parser.parse_from_string(torus_obj(rings));
+    const std::shared_ptr<Group> g = parser.obj_to_group();
+    const auto start = Clock::now();
+    BVHOptions options;
+    options.n_threads = n_threads;
+    g->divide(options);
+    scene.build_ms = ms_since(start);
+    scene.world.insert(g);
+    const ShapePtr floor = checkered_floor();
+    floor->set_transform(Transform::translation(0, -0.4f, 0));
+    scene.world.insert(floor);
+    scene.world.insert(std::make_shared<PointLight>(Point(-5, 8, -8), Color(1, 1, 1)));
+    return scene;
+}
+
+// A grid of spheres lit by n_lights coloured lights in a circle above them
+static Scene many_lights(int n_lights, unsigned n_threads) {
+    Scene scene = {"many_lights", World(), Transform::view_transform(Point(0, 6, -9), Point(0, 0, 0), Vector(0, 1, 0)), 0.0};
+    scene.world.insert(checkered_floor());
+    const auto start = Clock::now();
+    const auto spheres = std::make_shared<Group>();
+    for (int x = -4; x <= 4; x++) {
+        for (int z = -4; z <= 4; z++) {
+            const ShapePtr s = std::make_shared<Sphere>();
+            s->set_transform(Transform::translation(x, 0.4f, z) * Transform::scaling(0.4f, 0.4f, 0.4f));
+            spheres->add_child(s);
+        }
+    }
+    BVHOptions options;
+    options.n_threads = n_threads;
+    spheres->divide(options);
+    scene.build_ms = ms_since(start);
+    scene.world.insert(spheres);
+    for (int i = 0; i < n_lights; i++) {
+        const float a = 2.0f * M_PI * i / n_lights;
+        const Color c = Color(0.5f + 0.5f * std::cos(a), 0.5f + 0.5f * std::cos(a + 2.1f), 0.5f + 0.5f * std::cos(a + 4.2f));
+        scene.world.insert(std::make_shared<PointLight>(Point(6.0f * std::cos(a), 5, 6.0f * std::sin(a)), c * (2.0f / n_lights)));
+    }
+    return scene;
+}
+
+// Nested glass spheres, most of the rays are refracted a few times
+static Scene glass(int, unsigned) {
+    Scene scene = {"glass", World(), Transform::view_transform(Point(0, 1.5f, -5), Point(0, 1, 0), Vector(0, 1, 0)), 0.0};
+    scene.world.insert(checkered_floor());
+    for (int i = 0; i < 3; i++) {
+        const ShapePtr outer = std::make_shared<Sphere>();
+        outer->set_transform(Transform::translation(-2.2f + 2.2f * i, 1, 0));
+        outer->mod_material().set_color(Color(0.1f, 0.1f, 0.1f));
+        outer->mod_material().set_diffuse(0.1f);
+        outer->mod_material().set_reflective(0.9f);
+        outer->mod_material().set_transparency(0.9f);
+        outer->mod_material().set_refractive_index(1.5f);
+        scene.world.insert(outer);
+        const ShapePtr inner = std::make_shared<Sphere>();
+        inner->set_transform(Transform::translation(-2.2f + 2.2f * i, 1, 0) * Transform::scaling(0.5f, 0.5f, 0.5f));
+        inner->mod_material() = outer->get_material();
+        inner->mod_material().set_refractive_index(1.0f);
+        scene.world.insert(inner);
+    }
+    scene.world.insert(std::make_shared<PointLight>(Point(-5, 8, -8), Color(1, 1, 1)));
+    return scene;
+}
+
+const std::vector<SceneEntry>& scenes() {
+    static const std::vector<SceneEntry> all = {
+        {"csg_reflect", csg_reflect, 0},
+        {"sponge", sponge, 3},
+        {"mesh", mesh, 128},
+        {"many_lights", many_lights, 16},
+        {"glass", glass, 0},
+    };
+    return all;
+}
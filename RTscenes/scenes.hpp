@@ -0,0 +1,31 @@
+#ifndef scenes_hpp
+#define scenes_hpp
+
+#include "World.hpp"
+#include "Camera.hpp"
+
+#include <string>
+#include <vector>
+
+// Canned scenes for the end to end benchmarks. Building a scene includes building its BVHs, the time
+// that takes is reported separately from the render time.
+struct Scene {
+    std::string name;
+    World world;
+    Matrix<4, 4> view;
+    double build_ms;
+};
+
+// The BVHs of the scene are built on n_threads threads
+using SceneFunction = Scene (*)(int size, unsigned n_threads);
+
+struct SceneEntry {
+    const char *name;
+    SceneFunction make;
+    // Passed to make, e.g. the level of the sponge or the resolution of the mesh
+    int size;
+};
+
+const std::vector<SceneEntry>& scenes();
+
+#endif /* scenes_hpp */
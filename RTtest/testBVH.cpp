@@ -0,0 +1,297 @@
+#include "catch.hpp"
+#include "Tuple.hpp"
+#include "Shape.hpp"
+#include "Group.hpp"
+#include "Ray.hpp"
+#include "Intersection.hpp"
+#include "Transformations.hpp"
+#include "testHelper.hpp"
+#include "BVH.hpp"
+#include "ThreadPool.hpp"
+#include "ObjParser.hpp"
+#include "Triangle.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+// Returns the number of primitives below g and checks that no leaf holds more than threshold of them
+static size_t count_primitives(const std::shared_ptr<Group> &g, size_t threshold, bool *ok) {
+    size_t n = 0, n_leaves = 0;
+    for (const auto &child : g->members) {
+        const std::shared_ptr<Group> subgroup = std::dynamic_pointer_cast<Group>(child);
+        if (subgroup) {
+            n += count_primitives(subgroup, threshold, ok);
+        } else {
+            n_leaves++;
+            REQUIRE(child->get_parent() == g);
+        }
+    }
+    if (n_leaves > threshold)
+        *ok = false;
+    return n + n_leaves;
+}
+
+static size_t count_hits(const std::shared_ptr<Group> &g, int n) {
+    size_t hits = 0;
+    for (int x = 0; x < n; x++) {
+        for (int y = 0; y < n; y++) {
+            const Ray r = Ray(Point(3 * x, 3 * y, -5), Vector(0, 0, 1));
+            std::vector<Intersection> xs;
+            r.intersect(g, xs);
+            hits += xs.size();
+        }
+    }
+    return hits;
+}
+
+SCENARIO("Building a BVH over a group") {
+    GIVEN("Grids of spheres") {
+        WHEN("Dividing them with every method on 1 and 4 threads") {
+            THEN("All spheres are kept in leaves of at most 4 and can be hit") {
+                const BVHMethod methods[] = {BVHMethod::Midpoint, BVHMethod::SAH, BVHMethod::Morton};
+                const unsigned threads[] = {1, 4};
+                for (const BVHMethod method : methods) {
+                    for (const unsigned n_threads : threads) {
+                        std::shared_ptr<Group> g = sphere_grid(16);
+                        BVHOptions options;
+                        options.method = method;
+                        options.threshold = 4;
+                        options.n_threads = n_threads;
+                        g->divide(options);
+                        bool ok = true;
+                        REQUIRE(count_primitives(g, 4, &ok) == 256);
+                        REQUIRE(ok);
+                        REQUIRE(g->count() == 2);
+                        REQUIRE(g->bounds.min() == Point(-0.5, -0.5, -0.5));
+                        REQUIRE(g->bounds.max() == Point(45.5, 45.5, 0.5));
+                        REQUIRE(count_hits(g, 16) == 512);
+                        REQUIRE(g->sah_cost() > 1.0f);
+                        REQUIRE(g->sah_cost() < 10.0f);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Runs f and returns what it printed
+template <typename F>
+static std::string captured(F f) {
+    std::ostringstream os;
+    std::streambuf *old = std::cout.rdbuf(os.rdbuf());
+    f();
+    std::cout.rdbuf(old);
+    return os.str();
+}
+
+SCENARIO("Building a BVH over nested groups") {
+    GIVEN("A group of two grids of spheres") {
+        WHEN("Dividing it on 4 threads with logging") {
+            THEN("Both grids get a hierarchy and one build on the given threads is logged") {
+                const std::shared_ptr<Group> g = std::make_shared<Group>();
+                g->add_child(sphere_grid(8));
+                g->add_child(sphere_grid(8));
+                BVHOptions options;
+                options.n_threads = 4;
+                options.log = true;
+                const std::string log = captured([&]() { g->divide(options); });
+                REQUIRE(log.find("4 threads") != std::string::npos);
+                REQUIRE(std::count(log.begin(), log.end(), '\n') == 1);
+                bool ok = true;
+                REQUIRE(count_primitives(g, 4, &ok) == 128);
+                REQUIRE(ok);
+            }
+        }
+        WHEN("Dividing it with spatial splits on 4 threads") {
+            THEN("The build runs on one thread") {
+                const std::shared_ptr<Group> g = std::make_shared<Group>();
+                g->add_child(sphere_grid(8));
+                g->add_child(sphere_grid(8));
+                BVHOptions options;
+                options.method = BVHMethod::Spatial;
+                options.n_threads = 4;
+                options.log = true;
+                const std::string log = captured([&]() { g->divide(options); });
+                REQUIRE(log.find(" 1 threads") != std::string::npos);
+                bool ok = true;
+                REQUIRE(count_primitives(g, 4, &ok) == 128);
+                REQUIRE(ok);
+            }
+        }
+    }
+}
+
+// Parallel long triangles along the diagonal of the xy square [0, 20], whose bounds overlap a lot
+static std::shared_ptr<Group> diagonal_triangles(int n) {
+    std::shared_ptr<Group> g = std::make_shared<Group>();
+    for (int i = 0; i < n; i++) {
+        const float c = 20.0f * i / n - 10.0f;
+        const Tuple p1 = Point(0, c, 0);
+        const Tuple p2 = Point(20, 20 + c, 0);
+        g->add_child(std::make_shared<Triangle>(p1, p2, p2 + Vector(0, 0, 1)), false);
+    }
+    g->update_bounds();
+    return g;
+}
+
+SCENARIO("Building a BVH with spatial splits") {
+    GIVEN("Long diagonal triangles and a copy of them") {
+        std::shared_ptr<Group> g = diagonal_triangles(128);
+        const std::shared_ptr<Group> reference = diagonal_triangles(128);
+        WHEN("Dividing the group with spatial splits") {
+            BVHOptions options;
+            options.method = BVHMethod::Spatial;
+            options.threshold = 4;
+            options.max_duplication = 0.5f;
+            BVHBuilder builder(options);
+            builder.build(*g);
+            THEN("Triangles are referenced from several leaves within the budget") {
+                REQUIRE(builder.n_references() > 128);
+                REQUIRE(builder.n_references() <= 192);
+                REQUIRE(g->bounds.min() == reference->bounds.min());
+                REQUIRE(g->bounds.max() == reference->bounds.max());
+            }
+            THEN("Every ray finds each triangle at most once") {
+                size_t hits = 0;
+                for (int y = 0; y < 8; y++) {
+                    for (int z = 0; z < 8; z++) {
+                        const Ray r = Ray(Point(-5, 2.5 * y, 0.125 * z), Vector(1, 0.1 * (y - 4), 0).normalize());
+                        const std::vector<float> expected = hit_distances(reference, r);
+                        REQUIRE(hit_distances(g, r) == expected);
+                        hits += expected.size();
+                    }
+                }
+                REQUIRE(hits > 0);
+            }
+            THEN("The leaves are tighter than their triangles and the tree is cheaper than a SAH build") {
+                const std::shared_ptr<Group> sah = diagonal_triangles(128);
+                BVHOptions sah_options;
+                sah_options.method = BVHMethod::SAH;
+                sah_options.threshold = 4;
+                BVHBuilder(sah_options).build(*sah);
+                REQUIRE(g->sah_cost() < sah->sah_cost());
+
+                size_t clipped = 0;
+                std::vector<std::shared_ptr<Group>> stack = {g};
+                while (!stack.empty()) {
+                    const std::shared_ptr<Group> node = stack.back();
+                    stack.pop_back();
+                    Bounds members;
+                    bool leaf = true;
+                    for (const ShapePtr &child : node->members) {
+                        const std::shared_ptr<Group> sub = std::dynamic_pointer_cast<Group>(child);
+                        if (sub) {
+                            stack.push_back(sub);
+                            leaf = false;
+                        }
+                        members.merge(child->bounds_transform);
+                    }
+                    if (leaf && node->bounds.surface_area() < members.surface_area() - EPSILON)
+                        clipped++;
+                }
+                REQUIRE(clipped > 0);
+            }
+            AND_WHEN("Flattening the group") {
+                g->flatten();
+                THEN("Every triangle is kept once") {
+                    REQUIRE(g->count() == 128);
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("Building a BVH over a small group leaves it untouched") {
+    GIVEN("A group with a single sphere") {
+        std::shared_ptr<Group> g = sphere_grid(1);
+        WHEN("Dividing the group") {
+            g->divide(BVHOptions());
+            THEN("It holds") {
+                REQUIRE(g->count() == 1);
+                REQUIRE(std::dynamic_pointer_cast<Sphere>(g->operator[](0)));
+            }
+        }
+    }
+}
+
+SCENARIO("Building a BVH over the groups of an OBJ file") {
+    GIVEN("An OBJ file with 2 groups") {
+        std::string obj = "v -1 1 0\nv -1 0 0\nv 1 0 0\nv 1 1 0\ng FirstGroup\n";
+        for (int i = 0; i < 8; i++)
+            obj += "f 1 2 3\n";
+        obj += "g SecondGroup\n";
+        for (int i = 0; i < 8; i++)
+            obj += "f 1 3 4\n";
+        ObjParser parser = ObjParser();
+        parser.parse_from_string(obj);
+        WHEN("Converting it to a group with a BVH") {
+            BVHOptions options;
+            options.threshold = 2;
+            std::shared_ptr<Group> g = parser.obj_to_group(options);
+            THEN("Every group gets its own hierarchy") {
+                REQUIRE(g->count() == 2);
+                bool ok = true;
+                REQUIRE(count_primitives(g, 2, &ok) == 16);
+                REQUIRE(ok);
+            }
+        }
+    }
+}
+
+SCENARIO("Running a parallel for on a thread pool") {
+    GIVEN("A pool of 4 threads") {
+        ThreadPool pool(4);
+        WHEN("Summing a range") {
+            std::atomic<size_t> sum(0);
+            pool.parallel_for(1000, 10, [&sum](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++)
+                    sum += i;
+            });
+            THEN("It holds") {
+                REQUIRE(pool.size() == 4);
+                REQUIRE(sum == 499500);
+            }
+        }
+    }
+}
+
+SCENARIO("A task that throws on a thread pool") {
+    GIVEN("A pool of 4 threads") {
+        ThreadPool pool(4);
+        WHEN("One of the tasks throws") {
+            std::atomic<int> done(0);
+            for (int i = 0; i < 16; i++) {
+                pool.submit([&done, i]() {
+                    if (i == 7)
+                        throw std::runtime_error("task failed");
+                    done++;
+                });
+            }
+            THEN("wait() rethrows once the other tasks are done and the pool can be used again") {
+                REQUIRE_THROWS_AS(pool.wait(), std::runtime_error);
+                REQUIRE(done == 15);
+                pool.submit([&done]() { done++; });
+                REQUIRE_NOTHROW(pool.wait());
+                REQUIRE(done == 16);
+            }
+        }
+    }
+}
+
+SCENARIO("Idle workers of a thread pool sleep") {
+    GIVEN("A pool of 4 threads without tasks") {
+        ThreadPool pool(4);
+        WHEN("Waiting for a while") {
+            const std::clock_t start = std::clock();
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            const double cpu_ms = 1000.0 * (std::clock() - start) / CLOCKS_PER_SEC;
+            THEN("The process used hardly any processor time") {
+                REQUIRE(cpu_ms < 50.0);
+            }
+        }
+    }
+}
@@ -250,3 +250,35 @@ SCENARIO("Splitting an z-wide box") {
         }
     }
 }
+
+SCENARIO("The surface area of a box") {
+    GIVEN("Given a box and an empty box") {
+        const Bounds box = Bounds(Point(-1, -2, -3), Point(1, 2, 3));
+        const Bounds empty = Bounds();
+        THEN("It holds") {
+            REQUIRE(box.surface_area() == Approx(88));
+            REQUIRE(empty.surface_area() == Approx(0));
+        }
+    }
+}
+
+SCENARIO("The interval of a ray inside a box") {
+    GIVEN("A box") {
+        const Bounds box = Bounds(Point(-1, -1, -1), Point(1, 1, 1));
+        WHEN("A ray passes through it, also starting inside of it") {
+            float t0, t1, u0, u1, v0, v1;
+            const bool hit = box.intersects(Ray(Point(0.5, 0, -5), Vector(0, 0, 1)), &t0, &t1);
+            const bool inside = box.intersects(Ray(Point(0, 0, 0), Vector(0, 0, 2)), &u0, &u1);
+            const bool miss = box.intersects(Ray(Point(2, 0, -5), Vector(0, 0, 1)), &v0, &v1);
+            THEN("It holds") {
+                REQUIRE(hit);
+                REQUIRE(t0 == Approx(4));
+                REQUIRE(t1 == Approx(6));
+                REQUIRE(inside);
+                REQUIRE(u0 == Approx(-0.5));
+                REQUIRE(u1 == Approx(0.5));
+                REQUIRE(!miss);
+            }
+        }
+    }
+}
@@ -208,3 +208,132 @@ SCENARIO("Subdividing a CSG shape subdivides its children") {
         }
     }
 }
+
+SCENARIO("Hits on members of nested groups of a CSG shape") {
+    GIVEN("A CSG of a nested group and a CSG") {
+        const std::shared_ptr<Sphere> s1 = std::make_shared<Sphere>();
+        const std::shared_ptr<Sphere> s2 = std::make_shared<Sphere>();
+        const std::shared_ptr<Cube> s3 = std::make_shared<Cube>();
+        const std::shared_ptr<Cube> s4 = std::make_shared<Cube>();
+        const std::shared_ptr<Group> left = std::make_shared<Group>();
+        left->add_child(s1);
+        left->make_subgroup(s2);
+        const std::shared_ptr<CSG> right = CSG::create(std::make_shared<csgUnionOperator>(), s3, s4);
+        const std::shared_ptr<CSG> shape = CSG::create(std::make_shared<csgDifferenceOperator>(), left, right);
+        THEN("The nested members belong to their operand") {
+            REQUIRE(left->includes(s2));
+            REQUIRE(shape->includes(s4));
+            REQUIRE_FALSE(left->includes(s3));
+        }
+        WHEN("Filtering hits of the nested members") {
+            std::vector<Intersection> xs {{1, s2}, {2, s3}, {3, s2}, {4, s3}};
+            shape->filter_intersections(xs);
+            THEN("They are found in the left operand") {
+                REQUIRE(xs.size() == 2);
+                REQUIRE(xs[0] == Intersection(1, s2));
+                REQUIRE(xs[1] == Intersection(2, s3));
+            }
+        }
+    }
+}
+
+SCENARIO("Dividing a CSG shape keeps the members of its operands") {
+    GIVEN("A CSG of two groups of spheres") {
+        const std::shared_ptr<Group> left = std::make_shared<Group>();
+        const std::shared_ptr<Group> right = std::make_shared<Group>();
+        std::vector<std::shared_ptr<Sphere>> spheres;
+        for (int i = 0; i < 8; i++) {
+            const std::shared_ptr<Sphere> s = std::make_shared<Sphere>();
+            s->set_transform(Transform::translation(3 * i, 0, 0));
+            (i % 2 ? right : left)->add_child(s);
+            spheres.push_back(s);
+        }
+        const std::shared_ptr<CSG> shape = CSG::create(std::make_shared<csgUnionOperator>(), left, right);
+        WHEN("Dividing it") {
+            shape->divide(1);
+            THEN("Each sphere is found in its own operand only") {
+                for (int i = 0; i < 8; i++) {
+                    REQUIRE((i % 2 ? right : left)->includes(spheres[i]));
+                    REQUIRE_FALSE((i % 2 ? left : right)->includes(spheres[i]));
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("Merging the sorted hits of both operands") {
+    GIVEN("A difference of a sphere and a union of two cubes") {
+        const std::shared_ptr<Sphere> s = std::make_shared<Sphere>();
+        s->set_transform(Transform::scaling(2, 2, 2));
+        const std::shared_ptr<Cube> c1 = std::make_shared<Cube>();
+        c1->set_transform(Transform::translation(0, 0, -2) * Transform::scaling(0.5, 0.5, 0.5));
+        const std::shared_ptr<Cube> c2 = std::make_shared<Cube>();
+        c2->set_transform(Transform::translation(0, 0, 2) * Transform::scaling(0.5, 0.5, 0.5));
+        const std::shared_ptr<CSG> u = CSG::create(std::make_shared<csgUnionOperator>(), c1, c2);
+        const std::shared_ptr<CSG> shape = CSG::create(std::make_shared<csgDifferenceOperator>(), s, u);
+        WHEN("A ray passes through all of them") {
+            const Ray r = Ray(Point(0, 0, -5), Vector(0, 0, 1));
+            std::vector<Intersection> xs {{-1, s}};
+            shape->intersect(r, xs);
+            THEN("The surviving hits are appended in order") {
+                REQUIRE(xs.size() == 3);
+                REQUIRE(xs[0].get_distance() == -1);
+                REQUIRE(equal(xs[1].get_distance(), 3.5));
+                REQUIRE(xs[1].get_shape() == c1);
+                REQUIRE(equal(xs[2].get_distance(), 6.5));
+                REQUIRE(xs[2].get_shape() == c2);
+            }
+        }
+    }
+}
+
+SCENARIO("Operands that cannot contribute are not intersected") {
+    const Ray r = Ray(Point(0, 0, -5), Vector(0, 0, 1));
+    GIVEN("An intersection whose right operand is missed") {
+        const std::shared_ptr<TestShape> left = std::make_shared<TestShape>();
+        const std::shared_ptr<Sphere> right = std::make_shared<Sphere>();
+        right->set_transform(Transform::translation(5, 0, 0));
+        const std::shared_ptr<CSG> shape = CSG::create(std::make_shared<csgIntersectionOperator>(), left, right);
+        WHEN("Intersecting it") {
+            std::vector<Intersection> xs;
+            shape->intersect(r, xs);
+            THEN("The left operand is skipped") {
+                REQUIRE(xs.empty());
+                REQUIRE(left->local_ray.get_direction() == Vector(0, 0, 0));
+            }
+        }
+    }
+    GIVEN("A difference whose right operand lies behind the left one along the ray") {
+        const std::shared_ptr<Sphere> left = std::make_shared<Sphere>();
+        const std::shared_ptr<TestShape> right = std::make_shared<TestShape>();
+        right->set_transform(Transform::translation(0, 0, 5));
+        const std::shared_ptr<CSG> shape = CSG::create(std::make_shared<csgDifferenceOperator>(), left, right);
+        WHEN("Intersecting it") {
+            std::vector<Intersection> xs;
+            shape->intersect(r, xs);
+            THEN("The right operand is skipped") {
+                REQUIRE(xs.size() == 2);
+                REQUIRE(right->local_ray.get_direction() == Vector(0, 0, 0));
+            }
+        }
+    }
+    GIVEN("A difference with a union that is only partly inside the left operand") {
+        const std::shared_ptr<Sphere> left = std::make_shared<Sphere>();
+        const std::shared_ptr<TestShape> far = std::make_shared<TestShape>();
+        far->set_transform(Transform::translation(0, 0, 5));
+        const std::shared_ptr<Sphere> near = std::make_shared<Sphere>();
+        near->set_transform(Transform::translation(0, 0, -1) * Transform::scaling(0.5, 0.5, 0.5));
+        const std::shared_ptr<CSG> right = CSG::create(std::make_shared<csgUnionOperator>(), far, near);
+        const std::shared_ptr<CSG> shape = CSG::create(std::make_shared<csgDifferenceOperator>(), left, right);
+        WHEN("Intersecting it") {
+            std::vector<Intersection> xs;
+            shape->intersect(r, xs);
+            THEN("Only the part of the union inside the left operand is intersected") {
+                REQUIRE(xs.size() == 2);
+                REQUIRE(equal(xs[0].get_distance(), 4.5));
+                REQUIRE(equal(xs[1].get_distance(), 6));
+                REQUIRE(far->local_ray.get_direction() == Vector(0, 0, 0));
+            }
+        }
+    }
+}
@@ -10,6 +10,8 @@
 #include "PointLight.hpp"
 #include "World.hpp"
 #include "Camera.hpp"
+#include "Group.hpp"
+#include "Plane.hpp"
 #include "testHelper.hpp"
 
 SCENARIO("Constructing a camera") {
@@ -103,3 +105,158 @@ SCENARIO("Rendering a world with a camera") {
         }
     }
 }
+
+SCENARIO("The heatmap colour scale") {
+    THEN("It runs from blue over green to red") {
+        REQUIRE(heat_color(0.0f) == Color(0, 0, 1));
+        REQUIRE(heat_color(0.5f) == Color(0, 1, 0));
+        REQUIRE(heat_color(1.0f) == Color(1, 0, 0));
+        REQUIRE(heat_color(2.0f) == Color(1, 0, 0));
+    }
+}
+
+SCENARIO("Rendering a heatmap of the render time") {
+    GIVEN("The default world and a camera") {
+        const World w = default_world();
+        Camera c = Camera(11, 11, M_PI_2);
+        c.set_transform(Transform::view_transform(Point(0, 0, -5), Point(0, 0, 0), Vector(0, 1, 0)));
+        WHEN("A heatmap is rendered") {
+            std::vector<double> values;
+            const Canvas image = c.render_heatmap(w, HeatmapMetric::Time, &values);
+            THEN("Every pixel has a cost on the scale") {
+                REQUIRE(values.size() == 121);
+                const double max_value = *std::max_element(values.begin(), values.end());
+                for (uint32_t i = 0; i < values.size(); i++) {
+                    REQUIRE(values[i] > 0.0);
+                    REQUIRE(image.get_pixel(i % 11, i / 11) == heat_color(values[i] / max_value));
+                }
+            }
+        }
+    }
+}
+
+#ifdef RT_STATS
+SCENARIO("Rendering a heatmap of the node visits") {
+    GIVEN("A group of spheres and a camera looking at it") {
+        World w = default_world();
+        const auto g = std::make_shared<Group>();
+        for (int i = 0; i < 4; i++) {
+            const ShapePtr s = std::make_shared<Sphere>();
+            s->set_transform(Transform::translation(-1.5f + i, 0, 0) * Transform::scaling(0.4f, 0.4f, 0.4f));
+            g->add_child(s);
+        }
+        g->divide(1);
+        w.mod_objects() = {g};
+        Camera c = Camera(21, 21, M_PI_2);
+        c.set_transform(Transform::view_transform(Point(0, 0, -5), Point(0, 0, 0), Vector(0, 1, 0)));
+        WHEN("Heatmaps of the node visits and primitive tests are rendered") {
+            std::vector<double> nodes, prims;
+            c.render_heatmap(w, HeatmapMetric::NodeVisits, &nodes);
+            c.render_heatmap(w, HeatmapMetric::PrimitiveTests, &prims);
+            THEN("Rays through the group cost more than rays that miss its bounds") {
+                // A corner misses the group, the centre goes through its bounds
+                REQUIRE(nodes[0] == 1);
+                REQUIRE(prims[0] == 0);
+                REQUIRE(nodes[10 * 21 + 10] > 1);
+                REQUIRE(*std::max_element(prims.begin(), prims.end()) > 0);
+            }
+        }
+    }
+}
+#else
+SCENARIO("A heatmap of counters needs statistics") {
+    GIVEN("The default world and a camera") {
+        const World w = default_world();
+        const Camera c = Camera(11, 11, M_PI_2);
+        THEN("Only the time can be shown") {
+            REQUIRE_THROWS_AS(c.render_heatmap(w, HeatmapMetric::NodeVisits), std::runtime_error);
+            REQUIRE_THROWS_AS(c.render_heatmap(w, HeatmapMetric::PrimitiveTests), std::runtime_error);
+            REQUIRE_NOTHROW(c.render_heatmap(w, HeatmapMetric::Time));
+        }
+    }
+}
+#endif
+
+SCENARIO("Rendering a world on several threads") {
+    GIVEN("The default world and a camera") {
+        const World w = default_world();
+        Camera c = Camera(21, 15, M_PI_2);
+        c.set_transform(Transform::view_transform(Point(0, 0, -5), Point(0, 0, 0), Vector(0, 1, 0)));
+        WHEN("The image is rendered on one and on four threads") {
+            const Canvas single = c.render(w);
+            const Canvas parallel = c.render(w, 1, 4);
+            THEN("The images are the same") {
+                bool same = true;
+                for (uint32_t y = 0; y < 15; y++)
+                    for (uint32_t x = 0; x < 21; x++)
+                        same = same && single.get_pixel(x, y) == parallel.get_pixel(x, y);
+                REQUIRE(same);
+            }
+        }
+    }
+}
+
+static bool same_image(const Canvas &a, const Canvas &b) {
+    for (uint32_t y = 0; y < a.get_height(); y++)
+        for (uint32_t x = 0; x < a.get_width(); x++)
+            if (!(a.get_pixel(x, y) == b.get_pixel(x, y)))
+                return false;
+    return true;
+}
+
+SCENARIO("Capturing the primary hits of a camera") {
+    GIVEN("The default world and a camera looking past its edge") {
+        const World w = default_world();
+        Camera c = Camera(11, 11, M_PI_2);
+        c.set_transform(Transform::view_transform(Point(0, 0, -5), Point(0, 0, 0), Vector(0, 1, 0)));
+        WHEN("Capturing the hits") {
+            const GBuffer g = c.capture(w);
+            THEN("The centre pixel holds the hit on the outer sphere and the corner nothing") {
+                REQUIRE(g.get_width() == 11);
+                REQUIRE(g.get_height() == 11);
+                const IntersectionComp *comps = g.get_hit(5, 5);
+                REQUIRE(comps != nullptr);
+                REQUIRE(comps->object == w.get_objects()[0]);
+                REQUIRE(comps->point == Point(0, 0, -1));
+                REQUIRE(comps->normalv == Vector(0, 0, -1));
+                REQUIRE(comps->eyev == Vector(0, 0, -1));
+                REQUIRE(g.get_hit(0, 0) == nullptr);
+                REQUIRE(g.get_hit(11, 5) == nullptr);
+                REQUIRE(g.get_hit(5, 11) == nullptr);
+            }
+        }
+        WHEN("Rendering from hits captured at another resolution") {
+            const GBuffer g = Camera(21, 11, M_PI_2).capture(w);
+            THEN("The render is refused") {
+                REQUIRE_THROWS_AS(c.render(w, g), std::runtime_error);
+            }
+        }
+    }
+}
+
+SCENARIO("Rendering from captured hits after a change of materials and lights") {
+    GIVEN("A world with a reflective floor, a camera and the captured hits") {
+        World w = default_world();
+        const ShapePtr floor = std::make_shared<Plane>();
+        floor->set_transform(Transform::translation(0, -1, 0));
+        floor->mod_material().set_reflective(0.5);
+        w.insert(floor);
+        Camera c = Camera(21, 15, M_PI_2);
+        c.set_transform(Transform::view_transform(Point(0, 1, -5), Point(0, 0, 0), Vector(0, 1, 0)));
+        const GBuffer g = c.capture(w);
+        THEN("The image is the same as a full render") {
+            REQUIRE(same_image(c.render(w, g), c.render(w)));
+        }
+        WHEN("Changing a material and the light") {
+            w.get_objects()[0]->mod_material().set_color(Color(0.2, 0.3, 0.9));
+            floor->mod_material().set_reflective(0.9);
+            w.mod_lights()[0] = std::make_shared<PointLight>(Point(5, 10, -10), Color(1, 0.5, 0.5));
+            THEN("The image is the same as a full render, also on several threads") {
+                const Canvas full = c.render(w);
+                REQUIRE(same_image(c.render(w, g), full));
+                REQUIRE(same_image(c.render(w, g, 4), full));
+                REQUIRE(same_image(c.render(w, c.capture(w, 4)), full));
+            }
+        }
+    }
+}
@@ -184,3 +184,81 @@ SCENARIO("Subdividing a group partitions its children") {
     }
 }
 
+
+SCENARIO("Refitting a divided group keeps its topology") {
+    GIVEN("A divided group of 2 spheres") {
+        const std::shared_ptr<Sphere> s1 = std::make_shared<Sphere>();
+        s1->set_transform(Transform::translation(-2, 0, 0));
+        const std::shared_ptr<Sphere> s2 = std::make_shared<Sphere>();
+        s2->set_transform(Transform::translation(2, 0, 0));
+        std::shared_ptr<Group> g = std::make_shared<Group>();
+        g->add_children(s1, s2);
+        g->divide(1);
+        const ShapePtr left = g->operator[](0);
+        const ShapePtr right = g->operator[](1);
+        WHEN("Moving a sphere and refitting") {
+            s2->set_transform(Transform::translation(2, 3, 0));
+            g->refit();
+            THEN("It holds") {
+                REQUIRE(g->count() == 2);
+                REQUIRE(g->operator[](0) == left);
+                REQUIRE(g->operator[](1) == right);
+                REQUIRE(right->bounds_transform.max() == Point(3, 4, 1));
+                REQUIRE(g->bounds.min() == Point(-3, -1, -1));
+                REQUIRE(g->bounds.max() == Point(3, 4, 1));
+            }
+        }
+    }
+}
+
+SCENARIO("Dividing a group lowers its SAH cost") {
+    GIVEN("A group of 4 spread out spheres") {
+        std::shared_ptr<Group> g = std::make_shared<Group>();
+        for (int i = 0; i < 4; i++) {
+            const std::shared_ptr<Sphere> s = std::make_shared<Sphere>();
+            s->set_transform(Transform::translation(4 * i, 0, 0));
+            g->add_child(s);
+        }
+        const float flat_cost = g->sah_cost();
+        WHEN("Dividing the group") {
+            g->divide(1);
+            THEN("It holds") {
+                REQUIRE(flat_cost == Approx(5));
+                REQUIRE(g->sah_cost() < flat_cost);
+            }
+        }
+    }
+}
+
+SCENARIO("A degraded hierarchy is rebuilt instead of refit") {
+    GIVEN("A divided group of 4 spheres") {
+        std::vector<std::shared_ptr<Sphere>> spheres;
+        std::shared_ptr<Group> g = std::make_shared<Group>();
+        for (int i = 0; i < 4; i++) {
+            const std::shared_ptr<Sphere> s = std::make_shared<Sphere>();
+            s->set_transform(Transform::translation(4 * i, 0, 0));
+            g->add_child(s);
+            spheres.push_back(s);
+        }
+        g->divide(1);
+        WHEN("Slightly moving a sphere") {
+            spheres[1]->set_transform(Transform::translation(4, 0.5, 0));
+            THEN("It is refit") {
+                REQUIRE_FALSE(g->refit_or_rebuild(1, 1.1));
+            }
+        }
+        WHEN("Swapping the outer spheres") {
+            spheres[0]->set_transform(Transform::translation(12, 0, 0));
+            spheres[3]->set_transform(Transform::translation(0, 0, 0));
+            const bool rebuilt = g->refit_or_rebuild(1, 1.1);
+            std::vector<Intersection> xs;
+            const Ray r = Ray(Point(0, 0, -5), Vector(0, 0, 1));
+            r.intersect(g, xs);
+            THEN("It is rebuilt") {
+                REQUIRE(rebuilt);
+                REQUIRE(xs.size() == 2);
+                REQUIRE(xs[0].get_shape() == spheres[3]);
+            }
+        }
+    }
+}
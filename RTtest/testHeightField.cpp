@@ -0,0 +1,109 @@
+#include "catch.hpp"
+#include "Tuple.hpp"
+#include "Group.hpp"
+#include "Triangle.hpp"
+#include "Ray.hpp"
+#include "Intersection.hpp"
+#include "Transformations.hpp"
+#include "Canvas.hpp"
+#include "testHelper.hpp"
+#include "HeightField.hpp"
+
+static std::vector<float> bumps(uint32_t width, uint32_t depth) {
+    std::vector<float> heights;
+    for (uint32_t z = 0; z < depth; z++)
+        for (uint32_t x = 0; x < width; x++)
+            heights.push_back(0.5f + 0.3f * std::sin(0.7f * x) * std::cos(0.45f * z));
+    return heights;
+}
+
+// The same grid made of triangles
+static std::shared_ptr<Group> triangulate(uint32_t width, uint32_t depth, const std::vector<float> &heights) {
+    std::shared_ptr<Group> g = std::make_shared<Group>();
+    auto vertex = [&](uint32_t x, uint32_t z) {
+        return Point(-1.0f + 2.0f * x / (width - 1), heights[z * width + x], -1.0f + 2.0f * z / (depth - 1));
+    };
+    for (uint32_t z = 0; z + 1 < depth; z++) {
+        for (uint32_t x = 0; x + 1 < width; x++) {
+            g->add_child(std::make_shared<Triangle>(vertex(x, z), vertex(x + 1, z), vertex(x + 1, z + 1)));
+            g->add_child(std::make_shared<Triangle>(vertex(x, z), vertex(x + 1, z + 1), vertex(x, z + 1)));
+        }
+    }
+    return g;
+}
+
+SCENARIO("Intersecting a flat height field") {
+    GIVEN("A height field at 0.5") {
+        const std::shared_ptr<HeightField> h = std::make_shared<HeightField>(3, 3, std::vector<float>(9, 0.5f));
+        WHEN("Intersecting a ray from above") {
+            const Ray r = Ray(Point(0.3, 2, -0.4), Vector(0, -1, 0));
+            std::vector<Intersection> xs;
+            h->intersect(r, xs);
+            THEN("It is hit once with an upward normal") {
+                REQUIRE(xs.size() == 1);
+                REQUIRE(xs[0].get_distance() == Approx(1.5));
+                REQUIRE(h->normal_at(Point(0.3, 0.5, -0.4), xs[0]) == Vector(0, 1, 0));
+                REQUIRE(h->bounds.min() == Point(-1, 0.5, -1));
+                REQUIRE(h->bounds.max() == Point(1, 0.5, 1));
+            }
+        }
+        WHEN("Intersecting a ray that passes outside of it") {
+            const Ray r = Ray(Point(1.5, 2, 0), Vector(0, -1, 0));
+            std::vector<Intersection> xs;
+            h->intersect(r, xs);
+            THEN("It is missed") {
+                REQUIRE(xs.empty());
+            }
+        }
+    }
+}
+
+SCENARIO("A height field is hit like the triangles of its grid") {
+    GIVEN("A bumpy height field of 37 by 23 samples and its triangles") {
+        const std::vector<float> heights = bumps(37, 23);
+        const std::shared_ptr<HeightField> h = std::make_shared<HeightField>(37, 23, heights);
+        const std::shared_ptr<Group> g = triangulate(37, 23, heights);
+        WHEN("Intersecting grazing rays in many directions") {
+            THEN("Both give the same hits") {
+                size_t hits = 0;
+                for (int k = 0; k < 64; k++) {
+                    const float a = 0.37f * k;
+                    const Ray r = Ray(Point(-2 * std::cos(a), 0.85, -2 * std::sin(a)),
+                                      Vector(std::cos(a + 0.1f), -0.12f - 0.002f * k, std::sin(a + 0.1f)));
+                    std::vector<Intersection> xs, ys;
+                    h->intersect(r, xs);
+                    r.intersect(g, ys);
+                    std::sort(xs.begin(), xs.end());
+                    std::sort(ys.begin(), ys.end());
+                    REQUIRE(xs.size() == ys.size());
+                    for (size_t i = 0; i < xs.size(); i++)
+                        REQUIRE(xs[i].get_distance() == Approx(ys[i].get_distance()).margin(1e-4));
+                    hits += xs.size();
+                }
+                REQUIRE(hits > 64);
+            }
+        }
+    }
+}
+
+SCENARIO("Creating a height field from a canvas") {
+    GIVEN("A canvas with a ramp") {
+        Canvas c = Canvas(4, 2);
+        for (uint32_t x = 0; x < 4; x++) {
+            c.write_pixel(x, 0, Color(x / 3.0f, x / 3.0f, x / 3.0f));
+            c.write_pixel(x, 1, Color(x / 3.0f, 0, 0));
+        }
+        WHEN("Creating the height field") {
+            const std::shared_ptr<HeightField> h = HeightField::from_canvas(c);
+            THEN("It holds") {
+                REQUIRE(h->width() == 4);
+                REQUIRE(h->depth() == 2);
+                REQUIRE(h->height(3, 0) == Approx(1));
+                REQUIRE(h->height(3, 1) == Approx(1.0 / 3.0));
+                const Tuple n = h->normal_at(Point(0, 0.5, -1), Intersection(1, h));
+                REQUIRE(n[0] < 0);
+                REQUIRE(n[1] > 0);
+            }
+        }
+    }
+}
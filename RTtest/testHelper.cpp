@@ -1,4 +1,7 @@
 #include "testHelper.hpp"
+#include "Transformations.hpp"
+
+#include <algorithm>
 
 TestShape::TestShape() : local_ray(Ray(Point(0, 0, 0), Vector(0, 0, 0))) {
     bounds = Bounds(Point(-1, -1, -1), Point(1, 1, 1));
@@ -71,3 +74,26 @@ ShapePtr MappedCube() {
     return c;
 }
  
+
+std::shared_ptr<Group> sphere_grid(int n) {
+    std::shared_ptr<Group> g = std::make_shared<Group>();
+    for (int x = 0; x < n; x++) {
+        for (int y = 0; y < n; y++) {
+            const std::shared_ptr<Sphere> s = std::make_shared<Sphere>();
+            s->set_transform(Transform::translation(3 * x, 3 * y, 0) * Transform::scaling(0.5, 0.5, 0.5));
+            g->add_child(s, false);
+        }
+    }
+    g->update_bounds();
+    return g;
+}
+
+std::vector<float> hit_distances(const ShapePtr &s, const Ray &r) {
+    std::vector<Intersection> xs;
+    r.intersect(s, xs);
+    std::vector<float> ts;
+    for (const Intersection &i : xs)
+        ts.push_back(i.get_distance());
+    std::sort(ts.begin(), ts.end());
+    return ts;
+}
@@ -8,6 +8,7 @@
 #include "Cube.hpp"
 #include "Pattern.hpp"
 #include "PointLight.hpp"
+#include "Group.hpp"
 
 class TestShape : public Shape {
 public:
@@ -29,6 +30,10 @@ public:
 World default_world();
 ShapePtr glass_sphere();
 ShapePtr MappedCube();
+// An n x n grid of spheres of radius 0.5, 3 apart in the xy plane, not divided yet
+std::shared_ptr<Group> sphere_grid(int n);
+// The distances of all hits of r on s, sorted
+std::vector<float> hit_distances(const ShapePtr &s, const Ray &r);
 
 #endif /* testHelper_hpp */
 
@@ -0,0 +1,130 @@
+#include "catch.hpp"
+#include "Tuple.hpp"
+#include "Matrix.hpp"
+#include "Shape.hpp"
+#include "Group.hpp"
+#include "Ray.hpp"
+#include "Intersection.hpp"
+#include "Transformations.hpp"
+#include "Material.hpp"
+#include "testHelper.hpp"
+#include "Instance.hpp"
+#include "Sphere.hpp"
+
+SCENARIO("Creating an instance of a shape") {
+    GIVEN("A transformed sphere") {
+        const std::shared_ptr<Sphere> s = std::make_shared<Sphere>();
+        s->set_transform(Transform::scaling(2, 2, 2));
+        s->mod_material().set_ambient(0.5);
+        WHEN("Creating an instance") {
+            const std::shared_ptr<Instance> inst = std::make_shared<Instance>(s);
+            THEN("It holds") {
+                REQUIRE(inst->prototype() == s);
+                REQUIRE(inst->get_material() == s->get_material());
+                REQUIRE(inst->bounds.min() == Point(-2, -2, -2));
+                REQUIRE(inst->bounds.max() == Point(2, 2, 2));
+                REQUIRE(s->get_parent() == nullptr);
+            }
+        }
+    }
+}
+
+SCENARIO("Intersecting an instance reports the instance and the primitive hit") {
+    GIVEN("A group holding a sphere and an instance of the group") {
+        const std::shared_ptr<Group> g = std::make_shared<Group>();
+        const std::shared_ptr<Sphere> s = std::make_shared<Sphere>();
+        g->add_child(s);
+        const std::shared_ptr<Instance> inst = std::make_shared<Instance>(g);
+        inst->set_transform(Transform::translation(5, 0, 0));
+        WHEN("Intersecting a ray with the instance") {
+            const Ray r = Ray(Point(5, 0, -5), Vector(0, 0, 1));
+            std::vector<Intersection> xs;
+            r.intersect(inst, xs);
+            THEN("It holds") {
+                REQUIRE(xs.size() == 2);
+                REQUIRE(xs[0].get_distance() == Approx(4));
+                REQUIRE(xs[1].get_distance() == Approx(6));
+                REQUIRE(xs[0].get_shape() == inst);
+                REQUIRE(xs[0].get_leaf() == s);
+            }
+        }
+        WHEN("Missing the instance") {
+            const Ray r = Ray(Point(0, 0, -5), Vector(0, 0, 1));
+            std::vector<Intersection> xs;
+            r.intersect(inst, xs);
+            THEN("It holds") {
+                REQUIRE(xs.empty());
+            }
+        }
+    }
+}
+
+SCENARIO("Computing the normal on an instance") {
+    GIVEN("A translated sphere in a group and a scaled instance of the group") {
+        const std::shared_ptr<Group> g = std::make_shared<Group>();
+        const std::shared_ptr<Sphere> s = std::make_shared<Sphere>();
+        s->set_transform(Transform::translation(5, 0, 0));
+        g->add_child(s);
+        const std::shared_ptr<Group> top = std::make_shared<Group>();
+        const std::shared_ptr<Instance> inst = std::make_shared<Instance>(g);
+        inst->set_transform(Transform::scaling(1, 2, 3));
+        top->set_transform(Transform::rotation_y(M_PI / 2.0));
+        top->add_child(inst);
+        WHEN("Computing the normal through the instance") {
+            const Intersection i = Intersection(Intersection(1, s), inst);
+            const Tuple n = inst->normal_at(Point(1.7321, 1.1547, -5.5774), i);
+            THEN("It matches the normal of an equally transformed sphere") {
+                REQUIRE(n == Vector(0.2857, 0.42854, -0.85716));
+            }
+        }
+    }
+}
+
+SCENARIO("Instances share their prototype but can override its material") {
+    GIVEN("A sphere and two instances") {
+        const std::shared_ptr<Sphere> s = std::make_shared<Sphere>();
+        const std::shared_ptr<Instance> i1 = std::make_shared<Instance>(s);
+        const std::shared_ptr<Instance> i2 = std::make_shared<Instance>(s);
+        WHEN("Overriding the material of one instance") {
+            i2->mod_material().set_reflective(0.5);
+            THEN("It holds") {
+                REQUIRE(i1->prototype() == i2->prototype());
+                REQUIRE(i1->get_material() == s->get_material());
+                REQUIRE(i2->get_material().get_reflective() == Approx(0.5));
+                REQUIRE(s->get_material().get_reflective() == Approx(0.0));
+            }
+        }
+        WHEN("Modifying the material of a prototype with its own material") {
+            s->mod_material().set_reflective(0.2);
+            const std::shared_ptr<Instance> i3 = std::make_shared<Instance>(s);
+            s->mod_material().set_reflective(0.7);
+            THEN("The instance keeps the material it was made with") {
+                REQUIRE(i3->get_material().get_reflective() == Approx(0.2));
+                REQUIRE(s->get_material().get_reflective() == Approx(0.7));
+            }
+        }
+    }
+}
+
+SCENARIO("A divided group of instances acts as top-level structure") {
+    GIVEN("A row of instances of one sphere") {
+        const std::shared_ptr<Sphere> s = std::make_shared<Sphere>();
+        const std::shared_ptr<Group> g = std::make_shared<Group>();
+        for (int x = 0; x < 8; x++) {
+            const std::shared_ptr<Instance> inst = std::make_shared<Instance>(s);
+            inst->set_transform(Transform::translation(3 * x, 0, 0));
+            g->add_child(inst);
+        }
+        g->divide(2);
+        WHEN("Intersecting a ray with the instance at x = 9") {
+            const Ray r = Ray(Point(9, 0, -5), Vector(0, 0, 1));
+            std::vector<Intersection> xs;
+            r.intersect(g, xs);
+            THEN("It holds") {
+                REQUIRE(xs.size() == 2);
+                REQUIRE(xs[0].get_leaf() == s);
+                REQUIRE(std::dynamic_pointer_cast<const Instance>(xs[0].get_shape())->get_transform() == Transform::translation(9, 0, 0));
+            }
+        }
+    }
+}
@@ -235,3 +235,92 @@ SCENARIO("The area light with jittered samples") {
         REQUIRE(light->intensity_at(point, w) == res);
     }
 }
+
+SCENARIO("The adaptive area light intensity function") {
+    std::tuple<Tuple, float> p[] = {{Point(0, 0, 2), 0.0},
+                                    {Point(1, -1, 2), 0.25},
+                                    {Point(1.5, 0, 2), 0.5},
+                                    {Point(1.25, 1.25, 3), 0.75},
+                                    {Point(0, 0, -2), 1.0},};
+    World w = default_world();
+    const std::shared_ptr<AreaLight> light = std::make_shared<AreaLight>(Point(-0.5, -0.5, -5), Color(1, 1, 1), Vector(1, 0, 0), Vector(0, 1, 0), 2, 2);
+    light->set_adaptive(true);
+    for (auto &[point, result] : p) {
+        REQUIRE(light->intensity_at(point, w) == result);
+    }
+}
+
+SCENARIO("Adaptive sampling of a large area light") {
+    GIVEN("The default world and a 16x16 area light that counts its samples") {
+        World w = default_world();
+        const std::shared_ptr<AreaLight> light = std::make_shared<AreaLight>(Point(-0.5, -0.5, -5), Color(1, 1, 1), Vector(1, 0, 0), Vector(0, 1, 0), 16, 16);
+        int samples = 0;
+        light->set_jitter([&samples]() { samples++; return 0.5f; });
+        WHEN("Fully lit and fully shadowed points are shaded adaptively") {
+            light->set_adaptive(true);
+            THEN("Only the corners and the centre are sampled") {
+                REQUIRE(light->intensity_at(Point(0, 0, -2), w) == 1.0f);
+                REQUIRE(samples / 2 == 5);
+                samples = 0;
+                REQUIRE(light->intensity_at(Point(0, 0, 2), w) == 0.0f);
+                REQUIRE(samples / 2 == 5);
+            }
+        }
+        WHEN("Points in the penumbra are shaded adaptively") {
+            const Tuple points[] = {Point(1, -1, 2), Point(1.5, 0, 2), Point(1.25, 1.25, 3)};
+            THEN("The intensity is close to that of the full grid with fewer samples") {
+                for (const Tuple &point : points) {
+                    light->set_adaptive(false);
+                    const float full = light->intensity_at(point, w);
+                    light->set_adaptive(true);
+                    samples = 0;
+                    const float adaptive = light->intensity_at(point, w);
+                    REQUIRE(std::abs(adaptive - full) < 0.05f);
+                    REQUIRE(samples / 2 < 256);
+                }
+            }
+        }
+        WHEN("The spheres are glass and let light through") {
+            for (const ShapePtr &s : w.get_objects())
+                s->mod_material().set_transparency(0.5f);
+            w.set_transparent_shadows(true);
+            light->set_adaptive(true);
+            THEN("A point behind both of them gets the light through both") {
+                REQUIRE(light->intensity_at(Point(0, 0, 2), w) == Approx(0.25f));
+                REQUIRE(samples / 2 == 5);
+            }
+        }
+    }
+}
+
+SCENARIO("Lighting a point sample by sample") {
+    GIVEN("The default world and an area light of four samples") {
+        World w = default_world();
+        const ShapePtr s = w.get_objects()[0];
+        const Tuple eyev = Vector(0, 0, -1);
+        const Tuple normalv = Vector(0, 0, -1);
+        const std::shared_ptr<AreaLight> light = std::make_shared<AreaLight>(Point(-0.5, -0.5, -5), Color(1, 1, 1), Vector(1, 0, 0), Vector(0, 1, 0), 2, 2);
+        THEN("A point that sees the whole light is lit like without shadows") {
+            const Tuple p = Point(0, 0, -2);
+            REQUIRE(Lighting(s->get_material(), s, light, p, eyev, normalv, w) == Lighting(s->get_material(), s, light, p, eyev, normalv, 1.0f));
+        }
+        THEN("A point that sees none of the light only gets ambient light") {
+            const Tuple p = Point(0, 0, 2);
+            REQUIRE(Lighting(s->get_material(), s, light, p, eyev, normalv, w) == Lighting(s->get_material(), s, light, p, eyev, normalv, 0.0f));
+        }
+        THEN("A point in the penumbra is only lit by the samples it sees") {
+            const Tuple p = Point(1.5, 0, 2);
+            const Color ambient = Lighting(s->get_material(), s, light, p, eyev, normalv, 0.0f);
+            Color expected = Color::black();
+            for (size_t i = 0; i < light->n_samples(); i++) {
+                const Tuple sample = light->sample_point(i);
+                if (w.is_shadowed(p, sample))
+                    continue;
+                const LightPtr sample_light = std::make_shared<PointLight>(sample, Color(1, 1, 1));
+                expected = expected + (Lighting(s->get_material(), s, sample_light, p, eyev, normalv, 1.0f) - ambient);
+            }
+            REQUIRE(light->intensity_at(p, w) == 0.5f);
+            REQUIRE(Lighting(s->get_material(), s, light, p, eyev, normalv, w) == ambient + expected / 4.0f);
+        }
+    }
+}
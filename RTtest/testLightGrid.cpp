@@ -0,0 +1,116 @@
+#include "catch.hpp"
+#include "Tuple.hpp"
+#include "Light.hpp"
+#include "PointLight.hpp"
+#include "LightGrid.hpp"
+#include "World.hpp"
+#include "Camera.hpp"
+#include "Plane.hpp"
+#include "Sphere.hpp"
+#include "testHelper.hpp"
+
+#include <algorithm>
+
+// A grid of n x n small lights above the plane y = 0
+static std::vector<LightPtr> small_lights(int n, float radius) {
+    std::vector<LightPtr> lights;
+    for (int z = 0; z < n; z++) {
+        for (int x = 0; x < n; x++) {
+            const auto light = std::make_shared<PointLight>(Point(2.0f * x - n, 1, 2.0f * z - n), Color(1, 1, 1));
+            light->set_radius(radius);
+            lights.push_back(light);
+        }
+    }
+    return lights;
+}
+
+SCENARIO("A point light with a radius falls off with distance") {
+    GIVEN("A point light with radius 5") {
+        const auto light = std::make_shared<PointLight>(Point(0, 0, 0), Color(1, 1, 1));
+        light->set_radius(5.0f);
+        THEN("Its contribution goes down to nothing at the radius") {
+            REQUIRE(light->range() == 5.0f);
+            REQUIRE(light->attenuation(Point(0, 0, 0)) == 1.0f);
+            REQUIRE(light->attenuation(Point(1, 0, 0)) < light->attenuation(Point(0.5f, 0, 0)));
+            REQUIRE(light->attenuation(Point(4, 0, 0)) < light->attenuation(Point(1, 0, 0)));
+            REQUIRE(light->attenuation(Point(4.99f, 0, 0)) == Approx(0.0f).margin(1e-4));
+            REQUIRE(light->attenuation(Point(0, 5, 0)) == 0.0f);
+            REQUIRE(light->attenuation(Point(0, 0, 7)) == 0.0f);
+        }
+        THEN("A point out of range is not lit at all") {
+            const ShapePtr s = std::make_shared<Sphere>();
+            const Color c = Lighting(s->get_material(), s, light, Point(0, 0, -6), Vector(0, 0, -1), Vector(0, 0, -1), 1.0f);
+            REQUIRE(c == Color::black());
+        }
+    }
+    GIVEN("A point light without a radius") {
+        const auto light = std::make_shared<PointLight>(Point(0, 0, 0), Color(1, 1, 1));
+        THEN("It does not fall off") {
+            REQUIRE(light->range() == INF);
+            REQUIRE(light->attenuation(Point(100, 0, 0)) == 1.0f);
+        }
+    }
+}
+
+SCENARIO("Finding lights with a light grid") {
+    GIVEN("A grid of lights with a small radius and one without") {
+        std::vector<LightPtr> lights = small_lights(8, 1.5f);
+        lights.push_back(std::make_shared<PointLight>(Point(0, 10, 0), Color(1, 1, 1)));
+        WHEN("A light grid is built") {
+            const LightGrid grid = LightGrid(lights);
+            THEN("Every point finds all lights that reach it, and not many more") {
+                REQUIRE(grid.unbounded().size() == 1);
+                REQUIRE(grid.n_cells() > 1);
+                for (float x = -9.0f; x <= 9.0f; x += 0.37f) {
+                    for (float z = -9.0f; z <= 9.0f; z += 0.41f) {
+                        const Tuple p = Point(x, 0, z);
+                        const std::vector<LightPtr> &found = grid.lights_at(p);
+                        REQUIRE(found.size() <= 16);
+                        for (int i = 0; i < 64; i++) {
+                            if (lights[i]->attenuation(p) > 0.0f)
+                                REQUIRE(std::find(found.begin(), found.end(), lights[i]) != found.end());
+                        }
+                    }
+                }
+            }
+            THEN("Points far away find no lights") {
+                REQUIRE(grid.lights_at(Point(100, 0, 0)).empty());
+            }
+        }
+    }
+}
+
+SCENARIO("A light grid of lights that reach nothing") {
+    GIVEN("Lights with a radius of 0") {
+        const std::vector<LightPtr> lights = small_lights(4, 0.0f);
+        WHEN("A light grid is built") {
+            const LightGrid grid = LightGrid(lights);
+            THEN("It has a single cell") {
+                REQUIRE(grid.n_cells() == 1);
+                REQUIRE(grid.unbounded().empty());
+                REQUIRE(grid.lights_at(Point(100, 0, 0)).empty());
+            }
+        }
+    }
+}
+
+SCENARIO("Shading with a light grid") {
+    GIVEN("A plane lit by many small lights") {
+        World w = World();
+        w.insert(std::make_shared<Plane>());
+        for (const auto &light : small_lights(6, 2.5f))
+            w.insert(light);
+        Camera c = Camera(9, 9, M_PI / 2.0f);
+        c.set_transform(Transform::view_transform(Point(0, 8, -8), Point(0, 0, 0), Vector(0, 1, 0)));
+        const Canvas reference = c.render(w);
+        WHEN("Lights are found through a grid") {
+            w.build_light_grid();
+            const Canvas image = c.render(w);
+            THEN("The image is the same as with all lights") {
+                for (uint32_t y = 0; y < 9; y++)
+                    for (uint32_t x = 0; x < 9; x++)
+                        REQUIRE(image.get_pixel(x, y) == reference.get_pixel(x, y));
+            }
+        }
+    }
+}
@@ -0,0 +1,168 @@
+#include "catch.hpp"
+#include "Tuple.hpp"
+#include "Light.hpp"
+#include "PointLight.hpp"
+#include "AreaLight.hpp"
+#include "LightTree.hpp"
+#include "World.hpp"
+#include "Camera.hpp"
+#include "Plane.hpp"
+#include "Sphere.hpp"
+#include "testHelper.hpp"
+
+#include <map>
+
+// A row of lights above the plane y = 0, brighter to the right
+static std::vector<LightPtr> light_row(int n) {
+    std::vector<LightPtr> lights;
+    for (int i = 0; i < n; i++)
+        lights.push_back(std::make_shared<PointLight>(Point(i - n / 2.0f, 5, 0), Color(1, 1, 1) * (0.1f + 0.1f * i)));
+    return lights;
+}
+
+SCENARIO("Building a light tree") {
+    GIVEN("A row of lights") {
+        const std::vector<LightPtr> lights = light_row(9);
+        WHEN("A tree is built") {
+            const LightTree tree = LightTree(lights);
+            THEN("It is a binary tree with a leaf per light") {
+                REQUIRE(tree.n_nodes() == 2 * lights.size() - 1);
+            }
+        }
+    }
+}
+
+SCENARIO("Culling lights with a light tree") {
+    GIVEN("A tree of a row of lights above the plane y = 0") {
+        const std::vector<LightPtr> lights = light_row(8);
+        const LightTree tree = LightTree(lights);
+        std::vector<LightPtr> culled;
+        THEN("A surface facing the lights keeps all of them") {
+            tree.cull(Point(0, 0, 0), Vector(0, 1, 0), 0.0f, culled);
+            REQUIRE(culled.size() == lights.size());
+        }
+        THEN("A surface facing away from the lights keeps none") {
+            tree.cull(Point(0, 0, 0), Vector(0, -1, 0), 0.0f, culled);
+            REQUIRE(culled.empty());
+        }
+        THEN("Lights dimmer than the threshold are culled") {
+            tree.cull(Point(0, 0, 0), Vector(0, 1, 0), 0.45f, culled);
+            REQUIRE(culled.size() == 4);
+            for (const auto &light : culled)
+                REQUIRE(light->intensity().red() >= 0.45f);
+        }
+    }
+}
+
+SCENARIO("Sampling lights from a light tree") {
+    GIVEN("A tree of a row of lights") {
+        const std::vector<LightPtr> lights = light_row(7);
+        const LightTree tree = LightTree(lights);
+        WHEN("Lights are picked for evenly spread random numbers") {
+            const int n = 10000;
+            std::map<Light*, int> picks;
+            std::map<Light*, float> pdfs;
+            for (int i = 0; i < n; i++) {
+                float pdf;
+                const LightPtr light = tree.sample(Point(0, 0, 0), Vector(0, 1, 0), (i + 0.5f) / n, &pdf);
+                REQUIRE(light != nullptr);
+                picks[light.get()]++;
+                pdfs[light.get()] = pdf;
+            }
+            THEN("Every light is picked as often as its probability says") {
+                REQUIRE(picks.size() == lights.size());
+                float total = 0.0f;
+                for (const auto &[light, pdf] : pdfs) {
+                    total += pdf;
+                    REQUIRE(std::abs((float) picks[light] / n - pdf) < 0.001f);
+                }
+                REQUIRE(total == Approx(1.0f));
+            }
+        }
+        WHEN("The surface faces away from the lights") {
+            float pdf;
+            const LightPtr light = tree.sample(Point(0, 0, 0), Vector(0, -1, 0), 0.5f, &pdf);
+            THEN("No light is picked") {
+                REQUIRE(light == nullptr);
+                REQUIRE(pdf == 0.0f);
+            }
+        }
+    }
+}
+
+SCENARIO("Shading with a light tree") {
+    GIVEN("A plane lit by a row of lights") {
+        World w = World();
+        const ShapePtr floor = std::make_shared<Plane>();
+        w.insert(floor);
+        for (const auto &light : light_row(6))
+            w.insert(light);
+        Camera c = Camera(5, 5, M_PI / 3.0f);
+        c.set_transform(Transform::view_transform(Point(0, 3, -5), Point(0, 0, 0), Vector(0, 1, 0)));
+        const Canvas reference = c.render(w);
+        WHEN("Every light that reaches a point is shaded") {
+            w.build_light_tree();
+            const Canvas image = c.render(w);
+            THEN("The image is the same as with all lights") {
+                for (uint32_t y = 0; y < 5; y++)
+                    for (uint32_t x = 0; x < 5; x++)
+                        REQUIRE(image.get_pixel(x, y) == reference.get_pixel(x, y));
+            }
+        }
+        WHEN("Many lights are sampled per point") {
+            w.build_light_tree(4000);
+            const Canvas image = c.render(w);
+            THEN("The image converges to that with all lights") {
+                for (uint32_t y = 0; y < 5; y++) {
+                    for (uint32_t x = 0; x < 5; x++) {
+                        for (int k = 0; k < 3; k++)
+                            REQUIRE(image.get_pixel(x, y)[k] == Approx(reference.get_pixel(x, y)[k]).epsilon(0.05));
+                    }
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("Lights behind a surface with a light tree") {
+    GIVEN("A sphere with lights on every side of it") {
+        World w = World();
+        w.insert(std::make_shared<Sphere>());
+        for (const Tuple &position : {Point(0, 5, 0), Point(0, -5, 0), Point(5, 0, 0), Point(-5, 0, -5), Point(0, 0, 5)})
+            w.insert(std::make_shared<PointLight>(position, Color(0.3, 0.3, 0.3)));
+        Camera c = Camera(7, 7, M_PI / 3.0f);
+        c.set_transform(Transform::view_transform(Point(0, 0, -5), Point(0, 0, 0), Vector(0, 1, 0)));
+        const Canvas reference = c.render(w);
+        WHEN("Only the lights in front of each point are shaded") {
+            w.build_light_tree();
+            const Canvas image = c.render(w);
+            THEN("The lights behind it still add their ambient light") {
+                for (uint32_t y = 0; y < 7; y++)
+                    for (uint32_t x = 0; x < 7; x++)
+                        REQUIRE(image.get_pixel(x, y) == reference.get_pixel(x, y));
+            }
+        }
+        WHEN("The lights in front of each point are sampled") {
+            w.build_light_tree(4000);
+            const Canvas image = c.render(w);
+            THEN("The lights behind it still add their ambient light") {
+                for (uint32_t y = 0; y < 7; y++) {
+                    for (uint32_t x = 0; x < 7; x++) {
+                        for (int k = 0; k < 3; k++)
+                            REQUIRE(image.get_pixel(x, y)[k] == Approx(reference.get_pixel(x, y)[k]).epsilon(0.05));
+                    }
+                }
+            }
+        }
+        WHEN("Every light is behind a point") {
+            w.mod_lights() = {std::make_shared<PointLight>(Point(0, 0, 5), Color(1, 1, 1))};
+            w.build_light_tree(1);
+            const Canvas image = c.render(w);
+            w.clear_light_tree();
+            THEN("It still gets the ambient light") {
+                REQUIRE(image.get_pixel(3, 3) == c.render(w).get_pixel(3, 3));
+                REQUIRE(image.get_pixel(3, 3) != Color::black());
+            }
+        }
+    }
+}
@@ -0,0 +1,136 @@
+#include "catch.hpp"
+#include "Tuple.hpp"
+#include "Transformations.hpp"
+#include "Pattern.hpp"
+#include "Noise.hpp"
+#include "testHelper.hpp"
+
+#include <cmath>
+
+static std::vector<Tuple> noise_points() {
+    std::vector<Tuple> ps;
+    for (int x = -8; x <= 8; x++)
+        for (int y = -4; y <= 4; y++)
+            for (int z = -8; z <= 8; z++)
+                ps.push_back(Point(x * 0.731f + 0.05f, y * 1.37f - 0.3f, z * 0.413f));
+    return ps;
+}
+
+// Reference sum of octaves, one point at a time
+static float octaves_reference(const Tuple &p, int octaves, bool abs) {
+    float sum = 0.0f, frequency = 1.0f, amplitude = 1.0f;
+    for (int i = 0; i < octaves; i++) {
+        const float n = perlin_noise(Point(p.get_x() * frequency, p.get_y() * frequency, p.get_z() * frequency));
+        sum += amplitude * (abs ? std::fabs(n) : n);
+        frequency *= 2.0f;
+        amplitude *= 0.5f;
+    }
+    return sum;
+}
+
+SCENARIO("Noise: Perlin noise is 0 at integer points") {
+    GIVEN("Points on the integer lattice") {
+        THEN("The noise is 0") {
+            for (int x = -3; x <= 3; x++)
+                for (int y = -3; y <= 3; y++)
+                    for (int z = -3; z <= 3; z++)
+                        REQUIRE(perlin_noise(Point(x, y, z)) == Approx(0.0f).margin(EPSILON));
+        }
+    }
+}
+
+SCENARIO("Noise: Perlin noise is bounded, smooth and not constant") {
+    GIVEN("Points across several cells") {
+        const std::vector<Tuple> ps = noise_points();
+        THEN("The noise stays in [-1, 1] and changes little over a small step") {
+            float lo = 1.0f, hi = -1.0f;
+            for (const Tuple &p : ps) {
+                const float n = perlin_noise(p);
+                REQUIRE(std::fabs(n) <= 1.0f);
+                REQUIRE(std::fabs(perlin_noise(p + Vector(1e-3f, 0.0f, 0.0f)) - n) < 1e-2f);
+                lo = std::min(lo, n);
+                hi = std::max(hi, n);
+            }
+            REQUIRE(lo < -0.2f);
+            REQUIRE(hi > 0.2f);
+        }
+        THEN("The noise repeats every 256 units") {
+            for (const Tuple &p : ps)
+                REQUIRE(perlin_noise(p + Vector(256.0f, 0.0f, -256.0f)) == Approx(perlin_noise(p)).margin(1e-3f));
+        }
+    }
+}
+
+SCENARIO("Noise: 4 points at once") {
+    GIVEN("Points across several cells, including negative coordinates") {
+        const std::vector<Tuple> ps = noise_points();
+        THEN("Each result is the noise at that point") {
+            for (size_t i = 0; i + 4 <= ps.size(); i += 4) {
+                float x[4], y[4], z[4], out[4];
+                for (int j = 0; j < 4; j++) {
+                    x[j] = ps[i + j].get_x();
+                    y[j] = ps[i + j].get_y();
+                    z[j] = ps[i + j].get_z();
+                }
+                perlin_noise4(x, y, z, out);
+                for (int j = 0; j < 4; j++)
+                    REQUIRE(out[j] == Approx(perlin_noise(ps[i + j])).margin(1e-5f));
+            }
+        }
+    }
+}
+
+SCENARIO("Noise: fBm and turbulence sum the octaves") {
+    GIVEN("Points across several cells") {
+        const std::vector<Tuple> ps = noise_points();
+        THEN("The batched octaves give the sum of the single octaves") {
+            for (int octaves : {1, 3, 4, 6, 16}) {
+                for (const Tuple &p : ps) {
+                    REQUIRE(fbm(p, octaves) == Approx(octaves_reference(p, octaves, false)).margin(1e-4f));
+                    REQUIRE(turbulence(p, octaves) == Approx(octaves_reference(p, octaves, true)).margin(1e-4f));
+                }
+            }
+        }
+        THEN("A single octave of fBm is Perlin noise and turbulence is never negative") {
+            for (const Tuple &p : ps) {
+                REQUIRE(fbm(p, 1) == Approx(perlin_noise(p)).margin(1e-5f));
+                REQUIRE(turbulence(p, 4) >= 0.0f);
+            }
+        }
+    }
+}
+
+SCENARIO("Noise: Noise patterns blend between their colors") {
+    GIVEN("The noise patterns between black and white") {
+        const std::vector<PatternPtr> patterns = {
+            std::make_shared<PatternFbm>(Color::black(), Color::white()),
+            std::make_shared<PatternTurbulence>(Color::black(), Color::white()),
+            std::make_shared<PatternMarble>(Color::black(), Color::white()),
+            std::make_shared<PatternWood>(Color::black(), Color::white())
+        };
+        THEN("Every color is a gray in [0, 1] and the patterns are not uniform") {
+            for (const PatternPtr &pattern : patterns) {
+                float lo = 1.0f, hi = 0.0f;
+                for (const Tuple &p : noise_points()) {
+                    const Color c = pattern->color_at(p);
+                    REQUIRE(c.red() == Approx(c.green()));
+                    REQUIRE(c.red() == Approx(c.blue()));
+                    REQUIRE(c.red() >= -EPSILON);
+                    REQUIRE(c.red() <= 1.0f + EPSILON);
+                    lo = std::min(lo, c.red());
+                    hi = std::max(hi, c.red());
+                }
+                REQUIRE(hi - lo > 0.5f);
+            }
+        }
+    }
+}
+
+SCENARIO("Noise: A single octave of fBm at the lattice is halfway between the colors") {
+    GIVEN("A fBm pattern with one octave") {
+        const PatternFbm pattern(Color(1, 0, 0), Color(0, 0, 1), 1);
+        THEN("At an integer point the noise is 0") {
+            REQUIRE(pattern.color_at(Point(2, -1, 3)) == Color(0.5, 0, 0.5));
+        }
+    }
+}
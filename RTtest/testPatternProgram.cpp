@@ -0,0 +1,104 @@
+#include "catch.hpp"
+#include "Tuple.hpp"
+#include "Sphere.hpp"
+#include "Transformations.hpp"
+#include "Material.hpp"
+#include "Pattern.hpp"
+#include "PatternProgram.hpp"
+#include "testHelper.hpp"
+
+// Every binary pattern at least once, with transforms at several levels and a pattern the compiler does not know
+static PatternPtr nested_pattern() {
+    const PatternPtr stripes = std::make_shared<PatternStripe>(Color(1, 1, 1), Color(0, 0, 0));
+    stripes->set_transform(Transform::scaling(0.25, 0.25, 0.25) * Transform::rotation_y(M_PI / 4));
+    const PatternPtr test = std::make_shared<TestPattern>();
+    test->set_transform(Transform::translation(0.5, -1, 2));
+    const PatternPtr gradient = std::make_shared<PatternGradient>(stripes, test);
+    gradient->set_transform(Transform::rotation_z(0.3));
+    const PatternPtr rings = std::make_shared<PatternRing>(Color(1, 0, 0), Color(0, 0, 1));
+    const PatternPtr radial = std::make_shared<PatternRadialGradient>(rings, std::make_shared<PatternSolid>(Color(0, 1, 0)));
+    radial->set_transform(Transform::scaling(2, 2, 2));
+    const PatternPtr blend = std::make_shared<PatternBlend>(radial, std::make_shared<PatternCheckers>(Color(1, 1, 0), Color(0, 1, 1)));
+    const PatternPtr root = std::make_shared<PatternCheckers>(gradient, blend);
+    root->set_transform(Transform::translation(0.1, 0.2, 0.3));
+    return root;
+}
+
+static std::vector<Tuple> test_points() {
+    std::vector<Tuple> ps;
+    for (int x = -6; x <= 6; x++)
+        for (int y = -3; y <= 3; y++)
+            for (int z = -6; z <= 6; z++)
+                ps.push_back(Point(x * 0.37f, y * 0.61f, z * 0.29f));
+    return ps;
+}
+
+SCENARIO("PatternProgram: A compiled pattern gives the colors of the tree") {
+    GIVEN("A tree of patterns and its program") {
+        const PatternPtr tree = nested_pattern();
+        const PatternProgram program(tree);
+        THEN("Both have the same transform and color") {
+            REQUIRE(program.get_transform() == tree->get_transform());
+            for (const Tuple &p : test_points())
+                REQUIRE(program.color_at(p) == tree->color_at(p));
+        }
+    }
+}
+
+SCENARIO("PatternProgram: Evaluating a batch of points") {
+    GIVEN("A tree of patterns and its program") {
+        const PatternPtr tree = nested_pattern();
+        const PatternProgram program(tree);
+        const std::vector<Tuple> ps = test_points();
+        WHEN("Evaluating all points at once") {
+            std::vector<Color> out(ps.size());
+            program.colors_at(ps.data(), out.data(), ps.size());
+            THEN("Each color is that of the tree") {
+                for (size_t i = 0; i < ps.size(); i++)
+                    REQUIRE(out[i] == tree->color_at(ps[i]));
+            }
+        }
+    }
+}
+
+SCENARIO("PatternProgram: Solid children are folded") {
+    GIVEN("A blend of two solids and stripes of a single color") {
+        const PatternProgram blend(std::make_shared<PatternBlend>(Color(1, 0, 0), Color(0, 0, 1)));
+        const PatternProgram stripes(std::make_shared<PatternStripe>(Color(0.5, 0.5, 0.5), Color(0.5, 0.5, 0.5)));
+        const PatternProgram checkers(std::make_shared<PatternCheckers>(Color(1, 1, 1), Color(0, 0, 0)));
+        THEN("Only the pattern that picks between different colors keeps its children") {
+            REQUIRE(blend.n_nodes() == 1);
+            REQUIRE(blend.color_at(Point(3, 2, 1)) == Color(0.5, 0, 0.5));
+            REQUIRE(stripes.n_nodes() == 1);
+            REQUIRE(stripes.color_at(Point(1.5, 0, 0)) == Color(0.5, 0.5, 0.5));
+            REQUIRE(checkers.n_nodes() == 3);
+        }
+    }
+}
+
+SCENARIO("PatternProgram: Compiling the pattern of a material") {
+    GIVEN("A sphere with a nested pattern") {
+        const std::shared_ptr<Sphere> s = std::make_shared<Sphere>();
+        s->set_transform(Transform::scaling(2, 2, 2));
+        Material m;
+        m.set_pattern(nested_pattern());
+        const Material tree = m;
+        WHEN("Compiling the pattern") {
+            m.compile_pattern();
+            THEN("The material has the same colors") {
+                REQUIRE(std::dynamic_pointer_cast<PatternProgram>(m.get_pattern()) != nullptr);
+                for (const Tuple &p : test_points())
+                    REQUIRE(m.color_at(s, p) == tree.color_at(s, p));
+            }
+        }
+    }
+    GIVEN("A material with a solid color") {
+        Material m;
+        WHEN("Compiling the pattern") {
+            m.compile_pattern();
+            THEN("The pattern is kept") {
+                REQUIRE(std::dynamic_pointer_cast<PatternSolid>(m.get_pattern()) != nullptr);
+            }
+        }
+    }
+}
@@ -0,0 +1,93 @@
+#include "catch.hpp"
+#include "Tuple.hpp"
+#include "Ray.hpp"
+#include "Intersection.hpp"
+#include "Transformations.hpp"
+#include "testHelper.hpp"
+#include "SDF.hpp"
+
+SCENARIO("Sphere tracing a distance field sphere") {
+    GIVEN("A distance field sphere and a ray") {
+        const std::shared_ptr<SDFSphere> s = std::make_shared<SDFSphere>();
+        const Ray r = Ray(Point(0, 0.5, -5), Vector(0, 0, 1));
+        WHEN("Intersecting") {
+            std::vector<Intersection> xs;
+            s->intersect(r, xs);
+            THEN("The entry and the exit are found like for a sphere") {
+                REQUIRE(xs.size() == 2);
+                REQUIRE(xs[0].get_distance() == Approx(5 - std::sqrt(0.75f)).margin(0.001));
+                REQUIRE(xs[1].get_distance() == Approx(5 + std::sqrt(0.75f)).margin(0.001));
+                const Tuple n = s->normal_at(r.position(xs[0].get_distance()), xs[0]);
+                REQUIRE(n[1] == Approx(0.5).margin(0.001));
+                REQUIRE(n[2] == Approx(-std::sqrt(0.75f)).margin(0.001));
+            }
+        }
+    }
+}
+
+SCENARIO("Sphere tracing a transformed distance field") {
+    GIVEN("A scaled distance field sphere") {
+        const std::shared_ptr<SDFSphere> s = std::make_shared<SDFSphere>();
+        s->set_transform(Transform::scaling(2, 1, 1));
+        WHEN("Intersecting a ray along the scaled axis") {
+            const Ray r = Ray(Point(-5, 0, 0), Vector(1, 0, 0));
+            std::vector<Intersection> xs;
+            r.intersect(s, xs);
+            THEN("It holds") {
+                REQUIRE(xs.size() == 2);
+                REQUIRE(xs[0].get_distance() == Approx(3).margin(0.001));
+                REQUIRE(xs[1].get_distance() == Approx(7).margin(0.001));
+            }
+        }
+        WHEN("Missing it") {
+            const Ray r = Ray(Point(-5, 1.5, 0), Vector(1, 0, 0));
+            std::vector<Intersection> xs;
+            r.intersect(s, xs);
+            THEN("It holds") {
+                REQUIRE(xs.empty());
+            }
+        }
+    }
+}
+
+SCENARIO("Blending two distance field spheres") {
+    GIVEN("Two spheres that almost touch") {
+        const std::shared_ptr<SDFSphere> a = std::make_shared<SDFSphere>();
+        a->set_transform(Transform::translation(-1.1, 0, 0));
+        const std::shared_ptr<SDFSphere> b = std::make_shared<SDFSphere>();
+        b->set_transform(Transform::translation(1.1, 0, 0));
+        const std::shared_ptr<SDFBlend> blend = std::make_shared<SDFBlend>(a, b, 0.5);
+        WHEN("Intersecting a ray through the gap") {
+            const Ray r = Ray(Point(0, 0, -5), Vector(0, 0, 1));
+            std::vector<Intersection> xs;
+            r.intersect(blend, xs);
+            THEN("The blend fills it") {
+                REQUIRE(xs.size() == 2);
+                REQUIRE(blend->distance(Point(0, 0, 0)) < 0);
+                REQUIRE(blend->distance(Point(3, 0, 0)) == Approx(0.9).margin(0.001));
+            }
+        }
+    }
+}
+
+SCENARIO("Sphere tracing fractals") {
+    GIVEN("A Mandelbulb and a quaternion Julia set") {
+        const std::shared_ptr<SDFMandelbulb> bulb = std::make_shared<SDFMandelbulb>();
+        const std::shared_ptr<SDFJulia> julia = std::make_shared<SDFJulia>(Tuple(-0.2, 0.6, 0.2, -0.2));
+        WHEN("Intersecting rays through their centres") {
+            const Ray r = Ray(Point(0.05, 0.07, -5), Vector(0, 0, 1));
+            std::vector<Intersection> xs, ys;
+            r.intersect(bulb, xs);
+            r.intersect(julia, ys);
+            THEN("They are hit within their bounds, on their surface") {
+                REQUIRE(!xs.empty());
+                REQUIRE(xs[0].get_distance() > 3.8);
+                REQUIRE(std::abs(bulb->distance(r.position(xs[0].get_distance()))) < 0.001);
+                REQUIRE(!ys.empty());
+                REQUIRE(ys[0].get_distance() > 3.5);
+                REQUIRE(std::abs(julia->distance(r.position(ys[0].get_distance()))) < 0.001);
+                REQUIRE(std::is_sorted(ys.begin(), ys.end()));
+            }
+        }
+    }
+}
@@ -109,6 +109,137 @@ SCENARIO("Shape: Assigning a material") {
     }
 }
 
+// Read while the test files are initialized, which may be before the file of the material table is
+static const Material static_init_material = TestShape().get_material();
+
+SCENARIO("Shape: Shapes made during static initialization have the default material") {
+    THEN("The default material is there") {
+        REQUIRE(static_init_material == Material());
+    }
+}
+
+SCENARIO("Shape: New shapes share the default material") {
+    GIVEN("Two test shapes") {
+        const std::shared_ptr<TestShape> s1 = std::make_shared<TestShape>();
+        const std::shared_ptr<TestShape> s2 = std::make_shared<TestShape>();
+        THEN("Both refer to material 0") {
+            REQUIRE(s1->get_material_id() == 0);
+            REQUIRE(s2->get_material_id() == 0);
+            REQUIRE(&s1->get_material() == &s2->get_material());
+        }
+        WHEN("Modifying the material of one of them") {
+            s1->mod_material().set_ambient(1);
+            THEN("It gets its own material and the other one keeps the default") {
+                REQUIRE(s1->get_material_id() != 0);
+                REQUIRE(s1->get_material().get_ambient() == 1);
+                REQUIRE(s2->get_material() == Material());
+                REQUIRE(MaterialTable::get(0) == Material());
+            }
+        }
+    }
+}
+
+SCENARIO("Shape: Sharing a material by id") {
+    GIVEN("A test shape with a material and a second shape sharing it") {
+        const std::shared_ptr<TestShape> s1 = std::make_shared<TestShape>();
+        Material m;
+        m.set_diffuse(0.3);
+        s1->set_material(m);
+        const std::shared_ptr<TestShape> s2 = std::make_shared<TestShape>();
+        s2->set_material_id(s1->get_material_id());
+        THEN("Both read the same entry") {
+            REQUIRE(&s2->get_material() == &s1->get_material());
+        }
+        WHEN("The first shape sets a new material") {
+            m.set_diffuse(0.6);
+            s1->set_material(m);
+            THEN("The sharing shape keeps the old one") {
+                REQUIRE(s1->get_material().get_diffuse() == Approx(0.6));
+                REQUIRE(s2->get_material().get_diffuse() == Approx(0.3));
+            }
+        }
+        WHEN("The first shape modifies the material") {
+            s1->mod_material().set_specular(0.1);
+            THEN("The sharing shape is not affected") {
+                REQUIRE(s1->get_material().get_specular() == Approx(0.1));
+                REQUIRE(s2->get_material().get_specular() == Approx(Material().get_specular()));
+            }
+        }
+        WHEN("The shape that made the material it shares is destroyed") {
+            uint32_t id;
+            {
+                const std::shared_ptr<TestShape> s3 = std::make_shared<TestShape>();
+                m.set_diffuse(0.6);
+                s3->set_material(m);
+                id = s3->get_material_id();
+                s2->set_material_id(id);
+            }
+            THEN("The sharing shape keeps the material and may modify it in place") {
+                REQUIRE(s2->get_material().get_diffuse() == Approx(0.6));
+                s2->mod_material().set_specular(0.1);
+                REQUIRE(s2->get_material_id() == id);
+            }
+        }
+        WHEN("The sharing shape modifies the material") {
+            s2->mod_material().set_specular(0.1);
+            THEN("The owner is not affected") {
+                REQUIRE(s2->get_material_id() != s1->get_material_id());
+                REQUIRE(s2->get_material().get_diffuse() == Approx(0.3));
+                REQUIRE(s2->get_material().get_specular() == Approx(0.1));
+                REQUIRE(s1->get_material().get_specular() == Approx(Material().get_specular()));
+            }
+        }
+    }
+}
+
+SCENARIO("Shape: A copied shape shares the material until it is modified") {
+    GIVEN("A test shape with a material and a copy of it") {
+        const std::shared_ptr<TestShape> s1 = std::make_shared<TestShape>();
+        s1->mod_material().set_reflective(0.5);
+        const std::shared_ptr<TestShape> s2 = std::make_shared<TestShape>(*s1);
+        THEN("The copy refers to the same material") {
+            REQUIRE(s2->get_material_id() == s1->get_material_id());
+        }
+        WHEN("Modifying the material of the copy") {
+            s2->mod_material().set_reflective(0.1);
+            THEN("The original keeps its material") {
+                REQUIRE(s1->get_material().get_reflective() == Approx(0.5));
+                REQUIRE(s2->get_material().get_reflective() == Approx(0.1));
+            }
+        }
+    }
+}
+
+SCENARIO("Shape: The materials of destroyed shapes are reclaimed") {
+    GIVEN("The number of materials in use") {
+        const uint32_t n = MaterialTable::size();
+        WHEN("Making and destroying many shapes with their own materials") {
+            for (int i = 0; i < 1000; i++) {
+                const std::shared_ptr<TestShape> s = std::make_shared<TestShape>();
+                s->mod_material().set_pattern(std::make_shared<TestPattern>());
+                s->set_material(Material());
+                const TestShape copy = *s;
+            }
+            THEN("Their entries are freed and reused") {
+                REQUIRE(MaterialTable::size() == n);
+                const std::shared_ptr<TestShape> s = std::make_shared<TestShape>();
+                s->mod_material().set_diffuse(0.5);
+                REQUIRE(MaterialTable::size() == n + 1);
+            }
+        }
+        WHEN("A shape is assigned the id it already has") {
+            const std::shared_ptr<TestShape> s = std::make_shared<TestShape>();
+            s->mod_material().set_diffuse(0.5);
+            s->set_material_id(s->get_material_id());
+            *s = *s;
+            THEN("It keeps its material") {
+                REQUIRE(s->get_material().get_diffuse() == Approx(0.5));
+                REQUIRE(!MaterialTable::is_shared(s->get_material_id()));
+            }
+        }
+    }
+}
+
 SCENARIO("Shape: Intersecting a scaled shape with a ray") {
     GIVEN("The test shape") {
         const Ray r = Ray(Point(0, 0, -5), Vector(0, 0, 1));
@@ -0,0 +1,87 @@
+#include "catch.hpp"
+#include "Tuple.hpp"
+#include "Ray.hpp"
+#include "Intersection.hpp"
+#include "Transformations.hpp"
+#include "testHelper.hpp"
+#include "Sponge.hpp"
+
+// Tests a point against the digits of its coordinates at every level
+static bool in_sponge(const Tuple &p, int level) {
+    double x[3] = {(p[0] + 1.0) / 2.0, (p[1] + 1.0) / 2.0, (p[2] + 1.0) / 2.0};
+    for (int k = 0; k < level; k++) {
+        int idx[3];
+        for (int a = 0; a < 3; a++) {
+            x[a] *= 3.0;
+            idx[a] = std::clamp((int) std::floor(x[a]), 0, 2);
+            x[a] -= idx[a];
+        }
+        if (!Sponge::is_solid(idx[0], idx[1], idx[2]))
+            return false;
+    }
+    return true;
+}
+
+SCENARIO("A sponge of level 0 is a cube") {
+    GIVEN("A sponge and a ray") {
+        const std::shared_ptr<Sponge> s = std::make_shared<Sponge>(0);
+        const Ray r = Ray(Point(5, 0.5, 0), Vector(-1, 0, 0));
+        WHEN("Intersecting") {
+            std::vector<Intersection> xs;
+            s->intersect(r, xs);
+            THEN("It holds") {
+                REQUIRE(xs.size() == 2);
+                REQUIRE(xs[0].get_distance() == Approx(4));
+                REQUIRE(xs[1].get_distance() == Approx(6));
+                REQUIRE(s->normal_at(r.position(4), xs[0]) == Vector(1, 0, 0));
+                REQUIRE(s->normal_at(r.position(6), xs[1]) == Vector(-1, 0, 0));
+            }
+        }
+    }
+}
+
+SCENARIO("A ray through the holes of a sponge of level 1") {
+    GIVEN("A sponge") {
+        const std::shared_ptr<Sponge> s = std::make_shared<Sponge>(1);
+        WHEN("Intersecting a ray through the middle and one next to it") {
+            std::vector<Intersection> xs, ys;
+            s->intersect(Ray(Point(0, 0, -5), Vector(0, 0, 1)), xs);
+            s->intersect(Ray(Point(0.5, 0, -5), Vector(0, 0, 1)), ys);
+            THEN("The first one passes, the second one hits two cells") {
+                REQUIRE(xs.empty());
+                REQUIRE(ys.size() == 4);
+                REQUIRE(ys[0].get_distance() == Approx(4));
+                REQUIRE(ys[1].get_distance() == Approx(4 + 2.0 / 3.0));
+                REQUIRE(ys[2].get_distance() == Approx(5 + 1.0 / 3.0));
+                REQUIRE(ys[3].get_distance() == Approx(6));
+                REQUIRE(s->normal_at(Point(0.5, 0, -1.0 / 3.0), ys[1]) == Vector(0, 0, 1));
+                REQUIRE(s->normal_at(Point(0.5, 0, 1.0 / 3.0), ys[2]) == Vector(0, 0, -1));
+            }
+        }
+    }
+}
+
+SCENARIO("The hits of a sponge of level 3 bound its solid parts") {
+    GIVEN("A sponge") {
+        const int level = 3;
+        const std::shared_ptr<Sponge> s = std::make_shared<Sponge>(level);
+        WHEN("Intersecting rays at different heights") {
+            THEN("Points between entries and exits are inside, the others outside") {
+                size_t hits = 0;
+                for (int k = 0; k < 20; k++) {
+                    const Ray r = Ray(Point(-5, -0.93 + 0.09 * k, 0.11 - 0.05 * k), Vector(1, 0.07, 0.03 * (k % 3)).normalize());
+                    std::vector<Intersection> xs;
+                    s->intersect(r, xs);
+                    REQUIRE(xs.size() % 2 == 0);
+                    REQUIRE(std::is_sorted(xs.begin(), xs.end()));
+                    for (size_t i = 0; i + 1 < xs.size(); i++) {
+                        const float t = 0.5f * (xs[i].get_distance() + xs[i + 1].get_distance());
+                        REQUIRE(in_sponge(r.position(t), level) == (i % 2 == 0));
+                    }
+                    hits += xs.size();
+                }
+                REQUIRE(hits > 40);
+            }
+        }
+    }
+}
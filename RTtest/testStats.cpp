@@ -0,0 +1,144 @@
+#include "catch.hpp"
+#include "Tuple.hpp"
+#include "Ray.hpp"
+#include "World.hpp"
+#include "Camera.hpp"
+#include "Sphere.hpp"
+#include "Group.hpp"
+#include "WideBVH.hpp"
+#include "Transformations.hpp"
+#include "testHelper.hpp"
+#include "Stats.hpp"
+
+#include <sstream>
+#include <thread>
+
+SCENARIO("Shape types get stable statistics slots") {
+    GIVEN("Two shape types") {
+        const ShapePtr s = std::make_shared<Sphere>();
+        const ShapePtr g = std::make_shared<Group>();
+        THEN("Each type has its own slot") {
+            const int ss = Stats::type_slot(typeid(*s));
+            const int gs = Stats::type_slot(typeid(*g));
+            REQUIRE(ss != gs);
+            REQUIRE(Stats::type_slot(typeid(Sphere)) == ss);
+            REQUIRE(Stats::type_name(ss) == "Sphere");
+            REQUIRE(Stats::type_name(gs) == "Group");
+        }
+    }
+    GIVEN("A class template") {
+        THEN("Its name is readable") {
+            REQUIRE(Stats::type_name(Stats::type_slot(typeid(BVH4))) == "WideBVH<4>");
+        }
+    }
+}
+
+SCENARIO("Statistics can be printed and exported") {
+    GIVEN("Reset statistics") {
+        Stats::reset();
+        THEN("The summary lists every counter") {
+            std::ostringstream os;
+            Stats::print(os);
+            REQUIRE(os.str().find("Bounds tests:") != std::string::npos);
+            const std::string json = Stats::to_json();
+            REQUIRE(json.front() == '{');
+            REQUIRE(json.back() == '}');
+            REQUIRE(json.find("\"rays\": {\"camera\": 0") != std::string::npos);
+            REQUIRE(json.find("\"hits\": 0") != std::string::npos);
+        }
+    }
+}
+
+SCENARIO("Threads reuse the statistics slots of threads that exited") {
+    GIVEN("More threads than there are slots, one after another") {
+        THEN("They all count into the same slot") {
+            const StatsCounters *first = nullptr;
+            bool same = true;
+            for (int i = 0; i < STATS_MAX_THREADS + 16; i++) {
+                const StatsCounters *slot = nullptr;
+                std::thread([&slot]() { slot = &Stats::local(); }).join();
+                if (!first)
+                    first = slot;
+                same = same && slot == first;
+            }
+            REQUIRE(same);
+        }
+        THEN("Threads that run at the same time have their own slots") {
+            const StatsCounters *outer = nullptr, *inner = nullptr;
+            std::thread([&]() {
+                outer = &Stats::local();
+                std::thread([&inner]() { inner = &Stats::local(); }).join();
+            }).join();
+            REQUIRE(outer != inner);
+        }
+    }
+}
+
+SCENARIO("Groups and BVHs count as aggregates") {
+    GIVEN("A group, a BVH and a sphere") {
+        THEN("Only the sphere is a primitive") {
+            REQUIRE(Group().is_aggregate());
+            REQUIRE(BVH4::create(std::make_shared<Group>())->is_aggregate());
+            REQUIRE(!Sphere().is_aggregate());
+        }
+    }
+}
+
+#ifdef RT_STATS
+SCENARIO("Rendering collects statistics") {
+    GIVEN("The default world and a camera") {
+        const World w = default_world();
+        Camera c = Camera(11, 11, M_PI / 2.0f);
+        c.set_transform(Transform::view_transform(Point(0, 0, -5), Point(0, 0, 0), Vector(0, 1, 0)));
+        WHEN("A frame is rendered") {
+            Stats::reset();
+            c.render(w);
+            const StatsCounters total = Stats::collect();
+            THEN("Every pixel casts a camera ray") {
+                REQUIRE(total.rays[(int) RayKind::Camera] == 121);
+                REQUIRE(total.rays[(int) RayKind::Shadow] > 0);
+                REQUIRE(total.hits > 0);
+                REQUIRE(total.intersect_tests[Stats::type_slot(typeid(Sphere))] == 2 * (121 + total.rays[(int) RayKind::Shadow]));
+            }
+        }
+        WHEN("Collection is switched off") {
+            Stats::reset();
+            Stats::set_enabled(false);
+            c.render(w);
+            Stats::set_enabled(true);
+            THEN("Nothing is counted") {
+                REQUIRE(Stats::collect().rays[(int) RayKind::Camera] == 0);
+            }
+        }
+    }
+}
+
+SCENARIO("Statistics of threads are merged") {
+    GIVEN("A group with a sphere") {
+        const ShapePtr g = std::make_shared<Group>();
+        std::dynamic_pointer_cast<Group>(g)->add_child(std::make_shared<Sphere>());
+        const Ray r = Ray(Point(0, 0, -5), Vector(0, 0, 1));
+        WHEN("Four threads intersect it") {
+            Stats::reset();
+            std::vector<std::thread> threads;
+            for (int i = 0; i < 4; i++) {
+                threads.emplace_back([&]() {
+                    std::vector<Intersection> xs;
+                    for (int j = 0; j < 100; j++)
+                        r.intersect(g, xs);
+                });
+            }
+            for (auto &t : threads)
+                t.join();
+            const StatsCounters total = Stats::collect();
+            THEN("The counts of all threads add up") {
+                REQUIRE(total.intersect_tests[Stats::type_slot(typeid(Group))] == 400);
+                REQUIRE(total.intersect_tests[Stats::type_slot(typeid(Sphere))] == 400);
+                // The group is at depth 0, the sphere inside it at depth 1
+                REQUIRE(total.depth_sum == 400);
+                REQUIRE(total.allocations > 0);
+            }
+        }
+    }
+}
+#endif
@@ -0,0 +1,109 @@
+#include "catch.hpp"
+#include "Tuple.hpp"
+#include "Shape.hpp"
+#include "Group.hpp"
+#include "Plane.hpp"
+#include "Ray.hpp"
+#include "Intersection.hpp"
+#include "Transformations.hpp"
+#include "testHelper.hpp"
+#include "BVH.hpp"
+#include "WideBVH.hpp"
+
+// Compares the hits of rays through the grid, also between the spheres, and returns their number
+template <int N>
+static size_t compare_hits(const std::shared_ptr<WideBVH<N>> &bvh, const std::shared_ptr<Group> &reference, int n) {
+    size_t hits = 0;
+    for (int x = 0; x < 2 * n; x++) {
+        for (int y = 0; y < 2 * n; y++) {
+            const Ray r = Ray(Point(1.5 * x, 1.5 * y + 0.2, -5), Vector(0.05, -0.02, 1).normalize());
+            const std::vector<float> expected = hit_distances(reference, r);
+            REQUIRE(hit_distances(bvh, r) == expected);
+            hits += expected.size();
+        }
+    }
+    return hits;
+}
+
+SCENARIO("Collapsing a BVH into a 4 wide BVH") {
+    GIVEN("A divided grid of spheres and a copy of it") {
+        std::shared_ptr<Group> g = sphere_grid(16);
+        const std::shared_ptr<Group> reference = sphere_grid(16);
+        g->divide(BVHOptions());
+        WHEN("Collapsing it") {
+            const std::shared_ptr<BVH4> bvh = BVH4::create(g);
+            THEN("All spheres are kept and every ray hits the same") {
+                REQUIRE(bvh->n_primitives() == 256);
+                REQUIRE(bvh->n_nodes() < 128);
+                REQUIRE(bvh->bounds.min() == reference->bounds.min());
+                REQUIRE(bvh->bounds.max() == reference->bounds.max());
+                REQUIRE(compare_hits(bvh, reference, 16) > 0);
+            }
+        }
+    }
+}
+
+SCENARIO("Collapsing a BVH into an 8 wide BVH") {
+    GIVEN("A divided grid of spheres and a copy of it") {
+        std::shared_ptr<Group> g = sphere_grid(16);
+        const std::shared_ptr<Group> reference = sphere_grid(16);
+        const ShapePtr first = g->members[0];
+        g->divide(BVHOptions());
+        WHEN("Collapsing it") {
+            const std::shared_ptr<BVH8> bvh = BVH8::create(g);
+            THEN("Every ray hits the same and the spheres belong to the BVH") {
+                REQUIRE(bvh->n_primitives() == 256);
+                REQUIRE(compare_hits(bvh, reference, 16) > 0);
+                REQUIRE(bvh->includes(first));
+                REQUIRE(first->get_parent() == bvh);
+            }
+        }
+    }
+}
+
+SCENARIO("A wide BVH with a transform and a plane") {
+    GIVEN("A group with a sphere and a plane") {
+        std::shared_ptr<Group> g = std::make_shared<Group>();
+        g->set_transform(Transform::translation(0, 0, 5));
+        const std::shared_ptr<Sphere> s = std::make_shared<Sphere>();
+        const std::shared_ptr<Plane> p = std::make_shared<Plane>();
+        p->set_transform(Transform::translation(0, -2, 0));
+        g->add_children(s, p);
+        WHEN("Collapsing it") {
+            const std::shared_ptr<BVH4> bvh = BVH4::create(g);
+            const Ray r = Ray(Point(0, 0, -5), Vector(0, -0.1, 1).normalize());
+            std::vector<Intersection> xs;
+            r.intersect(bvh, xs);
+            std::sort(xs.begin(), xs.end());
+            THEN("Both are hit and normals are in world space") {
+                REQUIRE(bvh->n_primitives() == 2);
+                REQUIRE(xs.size() == 3);
+                REQUIRE(xs[0].get_shape() == s);
+                REQUIRE(xs[2].get_shape() == p);
+                const Tuple n = s->normal_at(Point(0, 0, 4), xs[0]);
+                REQUIRE(n == Vector(0, 0, -1));
+            }
+        }
+    }
+}
+
+SCENARIO("Refitting a wide BVH") {
+    GIVEN("A collapsed grid of spheres") {
+        std::shared_ptr<Group> g = sphere_grid(4);
+        const ShapePtr moved = g->members[5];
+        g->divide(BVHOptions());
+        const std::shared_ptr<BVH4> bvh = BVH4::create(g);
+        WHEN("Moving a sphere and refitting") {
+            moved->set_transform(Transform::translation(20, 20, 0) * Transform::scaling(0.5, 0.5, 0.5));
+            bvh->refit();
+            const Ray r = Ray(Point(20, 20, -5), Vector(0, 0, 1));
+            std::vector<Intersection> xs;
+            r.intersect(bvh, xs);
+            THEN("The sphere is found at its new position") {
+                REQUIRE(bvh->bounds.max() == Point(20.5, 20.5, 0.5));
+                REQUIRE(xs.size() == 2);
+                REQUIRE(xs[0].get_shape() == moved);
+            }
+        }
+    }
+}
@@ -10,6 +10,11 @@
 #include "Material.hpp"
 #include "PointLight.hpp"
 #include "World.hpp"
+#include "Group.hpp"
+#include "Cube.hpp"
+#include "CSG.hpp"
+#include "Triangle.hpp"
+#include "Stats.hpp"
 #include "testHelper.hpp"
 #include <iostream>
 
@@ -427,6 +432,202 @@ SCENARIO("is_shadow tests for occlusion between two points") {
     }
 }
 
+// Shadows of a transformed sphere in a group and of a cube with a hole cut through it
+static World occluder_world() {
+    World w = World();
+    const auto g = std::make_shared<Group>();
+    g->set_transform(Transform::translation(-2, 2, 0));
+    const ShapePtr ball = std::make_shared<Sphere>();
+    ball->set_transform(Transform::scaling(0.8, 0.8, 0.8));
+    g->add_child(ball);
+    w.insert(g);
+    const ShapePtr cube = std::make_shared<Cube>();
+    const ShapePtr hole = std::make_shared<Sphere>();
+    hole->set_transform(Transform::scaling(0.5, 4, 0.5));
+    const ShapePtr csg = CSG::create(std::make_shared<csgDifferenceOperator>(), cube, hole);
+    csg->set_transform(Transform::translation(2, 2, 0));
+    w.insert(csg);
+    w.insert(std::make_shared<PointLight>(Point(0, 10, 0), Color(1, 1, 1)));
+    return w;
+}
+
+SCENARIO("Caching the last occluder of a light") {
+    GIVEN("A world with shapes in groups and CSGs") {
+        World w = occluder_world();
+        const Light *light = w.get_lights()[0].get();
+        const Tuple light_p = light->position();
+        std::vector<Tuple> points;
+        for (float x = -4.0f; x <= 4.0f; x += 0.13f)
+            for (float z = -2.0f; z <= 2.0f; z += 0.17f)
+                points.push_back(Point(x, 0, z));
+        std::vector<bool> reference;
+        for (const Tuple &p : points)
+            reference.push_back(w.is_shadowed(p, light_p, light));
+        WHEN("The occluder cache is turned on") {
+            w.set_occluder_cache(true);
+            Stats::reset();
+            THEN("The shadows stay the same") {
+                for (size_t i = 0; i < points.size(); i++)
+                    REQUIRE(w.is_shadowed(points[i], light_p, light) == reference[i]);
+                REQUIRE(std::count(reference.begin(), reference.end(), true) > 0);
+#ifdef RT_STATS
+                REQUIRE(Stats::collect().occluder_hits > 0);
+#endif
+            }
+        }
+        WHEN("The group above the occluder moves after it was cached") {
+            w.set_occluder_cache(true);
+            const Tuple below_ball = Point(-2, 0, 0);
+            REQUIRE(w.is_shadowed(below_ball, light_p, light));
+            w.get_objects()[0]->set_transform(Transform::translation(-2, 2, 3));
+            THEN("The cached occluder is tested where it is now") {
+                REQUIRE(!w.is_shadowed(below_ball, light_p, light));
+                REQUIRE(w.is_shadowed(Point(-2, 0, 3), light_p, light));
+            }
+        }
+        WHEN("The occluder is removed after it was cached") {
+            w.set_occluder_cache(true);
+            const Tuple below_ball = Point(-2, 0, 0);
+            REQUIRE(w.is_shadowed(below_ball, light_p, light));
+            w.mod_objects().erase(w.mod_objects().begin());
+            THEN("It does not shadow anymore") {
+                REQUIRE(!w.is_shadowed(below_ball, light_p, light));
+            }
+        }
+    }
+}
+
+// The cube from -1 to 1 as a closed mesh of 12 triangles, each with its own copy of the material
+static ShapePtr glass_mesh(const Material &m) {
+    const auto mesh = std::make_shared<Group>();
+    auto corner = [](int i) {
+        return Point(i & 1 ? 1 : -1, i & 2 ? 1 : -1, i & 4 ? 1 : -1);
+    };
+    const int faces[6][4] = {{0, 1, 3, 2}, {4, 5, 7, 6}, {0, 1, 5, 4}, {2, 3, 7, 6}, {0, 2, 6, 4}, {1, 3, 7, 5}};
+    for (const auto &f : faces) {
+        for (const auto &[a, b, c] : {std::make_tuple(f[0], f[1], f[2]), std::make_tuple(f[0], f[2], f[3])}) {
+            const ShapePtr triangle = std::make_shared<Triangle>(corner(a), corner(b), corner(c));
+            triangle->set_material(m);
+            mesh->add_child(triangle);
+        }
+    }
+    return mesh;
+}
+
+SCENARIO("A cached occluder behind a shape that casts no shadow") {
+    GIVEN("A sphere that casts no shadow in front of a large opaque one") {
+        World w = World();
+        const ShapePtr front = std::make_shared<Sphere>();
+        front->set_transform(Transform::translation(0, 2, 0));
+        front->mod_material().set_shadow(false);
+        w.insert(front);
+        const ShapePtr back = std::make_shared<Sphere>();
+        back->set_transform(Transform::translation(0, 5, 0) * Transform::scaling(3, 1, 3));
+        w.insert(back);
+        w.insert(std::make_shared<PointLight>(Point(0, 10, 0), Color(1, 1, 1)));
+        const Light *light = w.get_lights()[0].get();
+        const Tuple p = Point(0, 0, 0);
+        THEN("Without the cache the nearest shape decides and the point is lit") {
+            REQUIRE(!w.is_shadowed(p, light->position(), light));
+        }
+        WHEN("The opaque sphere was cached by a ray that misses the other one") {
+            w.set_occluder_cache(true);
+            REQUIRE(w.is_shadowed(Point(2, 0, 0), light->position(), light));
+            THEN("The cached occluder shadows the point") {
+                REQUIRE(w.is_shadowed(p, light->position(), light));
+            }
+        }
+    }
+}
+
+// A unit glass sphere at the origin between the points (0, 0, -5) and (0, 0, 5)
+static World glass_world(float transparency, float absorption) {
+    World w = World();
+    const ShapePtr glass = std::make_shared<Sphere>();
+    glass->mod_material().set_transparency(transparency);
+    glass->mod_material().set_absorption(absorption);
+    w.insert(glass);
+    w.insert(std::make_shared<PointLight>(Point(0, 0, 5), Color(1, 1, 1)));
+    w.set_transparent_shadows(true);
+    return w;
+}
+
+SCENARIO("Light through transparent shapes") {
+    const Tuple p = Point(0, 0, -5);
+    const Tuple light_p = Point(0, 0, 5);
+    GIVEN("A glass sphere that does not absorb") {
+        const World w = glass_world(0.8f, 0.0f);
+        THEN("Its transparency gets through") {
+            REQUIRE(w.transmittance(p, light_p) == Approx(0.8f));
+            REQUIRE(w.get_lights()[0]->intensity_at(p, w) == Approx(0.8f));
+        }
+        THEN("Rays that miss it get all light") {
+            REQUIRE(w.transmittance(Point(2, 0, -5), Point(2, 0, 5)) == 1.0f);
+        }
+    }
+    GIVEN("A glass sphere that absorbs") {
+        const World w = glass_world(0.8f, 0.5f);
+        THEN("Beer's law attenuates the light by the thickness passed") {
+            REQUIRE(w.transmittance(p, light_p) == Approx(0.8f * std::exp(-0.5f * 2.0f)));
+            // Off centre the sphere is thinner
+            const float thickness = 2.0f * std::sqrt(1.0f - 0.6f * 0.6f);
+            REQUIRE(w.transmittance(Point(0.6f, 0, -5), Point(0.6f, 0, 5)) == Approx(0.8f * std::exp(-0.5f * thickness)).epsilon(1e-4));
+        }
+        THEN("From inside or towards a light inside only the part inside counts") {
+            REQUIRE(w.transmittance(Point(0, 0, 0), light_p) == Approx(0.8f * std::exp(-0.5f)));
+            REQUIRE(w.transmittance(p, Point(0, 0, 0)) == Approx(0.8f * std::exp(-0.5f)));
+        }
+    }
+    GIVEN("A closed triangle mesh of glass that absorbs") {
+        World w = World();
+        Material m;
+        m.set_transparency(0.8f);
+        m.set_absorption(0.5f);
+        w.insert(glass_mesh(m));
+        w.set_transparent_shadows(true);
+        THEN("The light passes the mesh once, through its whole thickness") {
+            REQUIRE(w.transmittance(Point(0.3f, 0.2f, -5), Point(0.3f, 0.2f, 5)) == Approx(0.8f * std::exp(-0.5f * 2.0f)));
+            REQUIRE(w.transmittance(Point(-0.4f, 0.1f, -5), Point(-0.4f, 0.1f, 5)) == Approx(0.8f * std::exp(-0.5f * 2.0f)));
+        }
+        THEN("A ray from inside the mesh counts the part inside") {
+            REQUIRE(w.transmittance(Point(0.3f, 0.2f, 0), Point(0.3f, 0.2f, 5)) == Approx(0.8f * std::exp(-0.5f * 1.0f)));
+            REQUIRE(w.transmittance(Point(0.3f, 0.2f, -5), Point(0.3f, 0.2f, 0.5f)) == Approx(0.8f * std::exp(-0.5f * 1.5f)));
+        }
+    }
+    GIVEN("An opaque sphere") {
+        const World w = glass_world(0.0f, 0.0f);
+        THEN("No light gets through") {
+            REQUIRE(w.transmittance(p, light_p) == 0.0f);
+        }
+    }
+    GIVEN("A row of dark glass spheres") {
+        World w = glass_world(0.2f, 0.0f);
+        for (int i = 1; i < 6; i++) {
+            const ShapePtr glass = std::make_shared<Sphere>();
+            glass->set_transform(Transform::translation(0, 0, 2.5f * i));
+            glass->mod_material().set_transparency(0.2f);
+            w.insert(glass);
+        }
+        THEN("Light stops once hardly any of it gets through") {
+            REQUIRE(w.transmittance(p, Point(0, 0, 20)) == 0.0f);
+        }
+    }
+    GIVEN("A glass sphere that casts no shadow") {
+        World w = glass_world(0.5f, 0.0f);
+        w.mod_objects()[0]->mod_material().set_shadow(false);
+        THEN("All light gets through") {
+            REQUIRE(w.transmittance(p, light_p) == 1.0f);
+        }
+    }
+    GIVEN("Transparent shadows turned off") {
+        World w = glass_world(0.8f, 0.0f);
+        w.set_transparent_shadows(false);
+        THEN("The glass blocks the light") {
+            REQUIRE(w.visibility(p, light_p) == 0.0f);
+        }
+    }
+}
+
 SCENARIO("Point lights evaluate the light intensity at a given point") {
     std::tuple<Tuple, float> p[] = {{Point(0, 1.0001, 0), 1.0},
                                    {Point(-1.0001, 0, 0), 1.0},
@@ -8,6 +8,9 @@ class AreaLight : public Light {
 public:
     AreaLight(Tuple position, Color intensity, Tuple v1, Tuple v2, int usteps, int vsteps);
     float intensity_at(const Tuple &p, const World &w) const override;
+    Tuple sample_point(size_t i) const override;
+    bool shade_per_sample() const override;
+    Bounds bounds() const override;
     Tuple point_on_light(float u, float v) const;
     Tuple corner() const;
     Tuple uvec() const;
@@ -16,14 +19,20 @@ public:
     int vsteps() const;
     float jitter_by() const;
     void set_jitter(std::function<float()>);
+    // Only refine the grid of samples where the corners and centre of a part of the light disagree
+    void set_adaptive(bool adaptive);
+    bool adaptive() const;
     bool operator==(const Light &rhs) const override;
 private:
+    float adaptive_intensity_at(const Tuple &p, const World &w) const;
+    float adaptive_lit(const Tuple &p, const World &w, int u0, int v0, int u1, int v1, std::vector<float> &visible) const;
     std::function<float()> jitter_;
     Tuple corner_;
     Tuple uvec_;
     Tuple vvec_;
     int usteps_;
     int vsteps_;
+    bool adaptive_;
 };
 
 #endif /* AreaLight_hpp */
@@ -0,0 +1,75 @@
+#ifndef BVH_hpp
+#define BVH_hpp
+
+#include "Bounds.hpp"
+#include "Tuple.hpp"
+#include "Types.hpp"
+
+#include <thread>
+#include <vector>
+
+class Group;
+class ThreadPool;
+
+enum class BVHMethod {
+    Midpoint,   // Split at the middle of the centroid bounds
+    SAH,        // Binned surface area heuristic
+    Morton,     // Linear BVH, primitives sorted along a Morton curve, fast to build but lower quality
+    Spatial     // SBVH, SAH that may also split primitive references across a plane, built on one thread
+};
+
+struct BVHOptions {
+    BVHMethod method = BVHMethod::SAH;
+    int threshold = 4;
+    unsigned n_threads = std::thread::hardware_concurrency();
+    bool log = false;
+    // Spatial splits are only tried when the children of the best object split overlap by more than
+    // this fraction of the root area, and at most max_duplication * primitives extra references are made
+    float spatial_alpha = 1e-5f;
+    float max_duplication = 0.3f;
+};
+
+// Top-down builder that replaces the members of a group by a hierarchy of subgroups. The upper levels
+// are built on the calling thread with parallel binning, the subtrees below are independent tasks.
+class BVHBuilder {
+public:
+    BVHBuilder(const BVHOptions &options);
+    void build(Group &root);
+    double build_ms() const;
+    size_t n_references() const;
+private:
+    struct Primitive {
+        ShapePtr shape;
+        Bounds bounds;
+        Tuple centroid;
+        uint32_t morton;
+    };
+    struct Task {
+        std::shared_ptr<Group> node;
+        size_t begin, end;
+    };
+    size_t build(Group &root, ThreadPool *pool);
+    void build_node(Group &node, size_t begin, size_t end, int depth, ThreadPool *pool);
+    size_t split(size_t begin, size_t end, ThreadPool *pool);
+    size_t split_midpoint(size_t begin, size_t end, const Bounds &centroids);
+    size_t split_sah(size_t begin, size_t end, const Bounds &centroids, ThreadPool *pool,
+                     float *cost=nullptr, Bounds *left=nullptr, Bounds *right=nullptr);
+    size_t split_morton(size_t begin, size_t end);
+    size_t split_median(size_t begin, size_t end, const Bounds &centroids);
+    Bounds centroid_bounds(size_t begin, size_t end) const;
+    void compute_morton(ThreadPool *pool);
+    void build_spatial(Group &node, std::vector<Primitive> &refs, int depth);
+    bool find_spatial_split(const std::vector<Primitive> &refs, const Bounds &node_bounds, int *axis, float *plane, float *cost) const;
+    bool clip(const Primitive &ref, int axis, float lo, float hi, Primitive *out) const;
+    BVHOptions options_;
+    std::vector<Primitive> prims_;
+    std::vector<Task> deferred_;
+    std::vector<Group*> upper_;
+    int spawn_depth_;
+    size_t n_references_;
+    size_t max_references_;
+    float root_area_;
+    double build_ms_;
+};
+
+#endif /* BVH_hpp */
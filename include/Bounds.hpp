@@ -17,6 +17,8 @@ public:
     bool contains_point(const Tuple &p);
     bool contains_bounds(const Bounds &b);
     bool intersects(const Ray &r) const;
+    bool intersects(const Ray &r, float *t0, float *t1) const;
+    float surface_area() const;
     void split_bounds(Bounds *left, Bounds *right) const;
     friend Bounds operator*(const Bounds &b, const Matrix<4, 4> &m);
 private:
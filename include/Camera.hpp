@@ -2,12 +2,19 @@
 #define Camera_hpp
 
 #include "Canvas.hpp"
+#include "GBuffer.hpp"
 #include "Matrix.hpp"
 #include "Ray.hpp"
 #include "Transformations.hpp"
 
 class Ray;
 
+// What a heatmap shows per pixel, the counters need a build with RT_STATS and render_heatmap() throws without it
+enum class HeatmapMetric {NodeVisits, PrimitiveTests, Time};
+
+// Maps 0 to blue, through cyan, green and yellow, to red at 1
+Color heat_color(float t);
+
 class Camera {
 public:
     Camera();
@@ -19,8 +26,15 @@ public:
     const Matrix<4, 4>& get_transform() const;
     Ray ray_for_pixel(uint32_t px, uint32_t py) const;
     void set_transform(const Matrix<4, 4> t);
-    Canvas render(const World &w, uint32_t samples=1) const;
+    Canvas render(const World &w, uint32_t samples=1, unsigned n_threads=1) const;
+    // Traces the camera rays through the pixel centres and keeps their hits
+    GBuffer capture(const World &w, unsigned n_threads=1) const;
+    // Same as render() with one sample, but starts from the hits in g instead of tracing the camera rays.
+    // Throws if g was captured at another resolution.
+    Canvas render(const World &w, const GBuffer &g, unsigned n_threads=1) const;
+    Canvas render_heatmap(const World &w, HeatmapMetric metric, std::vector<double> *values=nullptr) const;
 private:
+    void render_rows(const World &w, uint32_t samples, uint32_t begin, uint32_t end, Canvas &image) const;
     Matrix<4, 4> transform;
     Matrix<4, 4> transform_inv;
     uint32_t hsize;
@@ -0,0 +1,23 @@
+#ifndef GBuffer_hpp
+#define GBuffer_hpp
+
+#include "Intersection.hpp"
+
+#include <vector>
+
+// The primary hit of every pixel, so that a frame can be shaded again without tracing the camera rays. Materials
+// and lights may change in between, the shapes, their refractive indices and the camera may not.
+class GBuffer {
+public:
+    GBuffer(uint32_t width, uint32_t height);
+    uint32_t get_width() const;
+    uint32_t get_height() const;
+    // nullptr where the camera ray hit nothing, and outside of the buffer
+    const IntersectionComp* get_hit(uint32_t x, uint32_t y) const;
+    void write_hit(uint32_t x, uint32_t y, const IntersectionComp &comps);
+private:
+    uint32_t width, height;
+    std::vector<IntersectionComp> hits;
+};
+
+#endif /* GBuffer_hpp */
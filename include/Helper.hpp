@@ -19,6 +19,16 @@ constexpr float EPSILON = 0.00001 * 3;
 constexpr float SHADOW_BIAS = 0.0006; // For actual use
 
 constexpr uint8_t N_BOUNCE = 4;
+// Shadow rays with transparent shadows stop once less than this fraction of the light gets through
+constexpr float SHADOW_MIN_TRANSMITTANCE = 0.001f;
+
+// Refitting a BVH is cheaper than rebuilding it, until its SAH cost grew by more than this factor
+constexpr float BVH_MAX_DEGRADATION = 1.5f;
+
+// Sphere tracing: distance below which a distance field counts as hit, the step cap per ray and the over-relaxation factor
+constexpr float SDF_EPSILON = 0.0001;
+constexpr int SDF_MAX_STEPS = 512;
+constexpr float SDF_RELAXATION = 1.6f;
 
 constexpr float INF = std::numeric_limits<float>::infinity();
 
@@ -28,8 +38,9 @@ inline bool equal(float x, float y) {
 
 // https://stackoverflow.com/questions/1640258/need-a-fast-random-generator-for-c
 inline double random_dbl() {
-    static std::uniform_real_distribution<double> distribution(0.0, 1.0);
-    static std::mt19937 generator;
+    // Every thread has its own generator
+    thread_local std::uniform_real_distribution<double> distribution(0.0, 1.0);
+    thread_local std::mt19937 generator;
     return distribution(generator);
 }
 
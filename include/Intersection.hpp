@@ -28,14 +28,18 @@ class Intersection {
 public:
     Intersection(float distance, const ShapeConstPtr &s);
     Intersection(float distance, const ShapeConstPtr &s, float u, float v);
+    Intersection(const Intersection &i, const ShapeConstPtr &instance);
     float get_distance() const;
     ShapeConstPtr get_shape() const;
+    // The primitive hit inside an instanced acceleration structure, nullptr otherwise
+    ShapeConstPtr get_leaf() const;
     float u() const;
     float v() const;
     friend bool operator==(const Intersection &lhs, const Intersection &rhs);
     friend bool operator<(const Intersection &lhs, const Intersection &rhs);
 private:
     ShapeConstPtr shape;
+    ShapeConstPtr leaf;
     float distance;
     float u_;
     float v_;
@@ -4,6 +4,7 @@
 #include "Tuple.hpp"
 #include "Color.hpp"
 #include "Material.hpp"
+#include "Bounds.hpp"
 
 class World;
 
@@ -15,6 +16,16 @@ public:
     Color intensity() const;
     virtual bool operator==(const Light &rhs) const = 0;
     size_t n_samples() const;
+    // The i-th of the n_samples() points on the light
+    virtual Tuple sample_point(size_t i) const;
+    // Lights that estimate their visibility as a whole in intensity_at are not shaded sample by sample
+    virtual bool shade_per_sample() const;
+    // The space the samples lie in
+    virtual Bounds bounds() const;
+    // Beyond this distance the light contributes nothing
+    virtual float range() const;
+    // The fraction of the light that reaches p
+    virtual float attenuation(const Tuple &p) const;
     std::vector<Tuple> sample_cache_;
 protected:
     size_t n_samples_;
@@ -36,4 +47,12 @@ Color Lighting(const Material &m,
                const Tuple &normalv,
                float light_intensity=1.0);
 
+Color Lighting(const Material &m,
+               const ShapeConstPtr &s,
+               const LightPtr &light,
+               const Tuple &p,
+               const Tuple &eyev,
+               const Tuple &normalv,
+               const World &w);
+
 #endif /* Light_hpp */
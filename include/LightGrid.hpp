@@ -0,0 +1,29 @@
+#ifndef LightGrid_hpp
+#define LightGrid_hpp
+
+#include "Bounds.hpp"
+#include "Types.hpp"
+
+#include <vector>
+
+constexpr int LIGHT_GRID_MAX_CELLS = 64;
+
+// Uniform grid over the spheres of influence of the lights with a finite range. Every cell lists the
+// lights that may reach a point in it, lights without a range are listed separately and reach everywhere.
+class LightGrid {
+public:
+    LightGrid(const std::vector<LightPtr> &lights);
+    // The lights with a finite range that may reach p, empty outside of the grid
+    const std::vector<LightPtr>& lights_at(const Tuple &p) const;
+    const std::vector<LightPtr>& unbounded() const;
+    int n_cells() const;
+private:
+    Bounds bounds_;
+    int dims_[3];
+    float cell_size_[3];
+    std::vector<std::vector<LightPtr>> cells_;
+    std::vector<LightPtr> unbounded_;
+    std::vector<LightPtr> empty_;
+};
+
+#endif /* LightGrid_hpp */
@@ -0,0 +1,39 @@
+#ifndef LightTree_hpp
+#define LightTree_hpp
+
+#include "Bounds.hpp"
+#include "Types.hpp"
+
+#include <vector>
+
+// Binary hierarchy over the lights of a world, every node knows the bounds and the total power of the
+// lights below it. Shading can cull the nodes that cannot reach a shading point, or pick lights at
+// random in proportion to an estimate of their contribution, both in time logarithmic in the number
+// of lights for the nodes that matter.
+class LightTree {
+public:
+    LightTree(const std::vector<LightPtr> &lights);
+    // Appends the lights whose contribution at p, on a surface with normal n, can reach threshold
+    void cull(const Tuple &p, const Tuple &n, float threshold, std::vector<LightPtr> &out) const;
+    // Picks a light for u in [0, 1), pdf is the probability it was picked with. Returns nullptr when
+    // no light can contribute.
+    LightPtr sample(const Tuple &p, const Tuple &n, float u, float *pdf) const;
+    size_t n_nodes() const;
+private:
+    struct Node {
+        Bounds bounds;
+        float power;
+        float range;
+        int left, right;
+        // Index of the light of a leaf, -1 for inner nodes
+        int light;
+    };
+    int build(std::vector<int> &indices, size_t begin, size_t end);
+    float bound(const Node &node, const Tuple &p, const Tuple &n) const;
+    float importance(const Node &node, const Tuple &p, const Tuple &n) const;
+    void cull(int index, const Tuple &p, const Tuple &n, float threshold, std::vector<LightPtr> &out) const;
+    std::vector<LightPtr> lights_;
+    std::vector<Node> nodes_;
+};
+
+#endif /* LightTree_hpp */
@@ -18,6 +18,8 @@ public:
     float get_transparency() const;
     float get_refractive_index() const;
     bool get_shadow() const;
+    // Fraction of light absorbed per unit of distance travelled through the material
+    float get_absorption() const;
     void set_color(const Color &c);
     void set_ambient(float n_ambient);
     void set_diffuse(float n_diffuse);
@@ -27,12 +29,15 @@ public:
     void set_transparency(float n_transparency);
     void set_refractive_index(float n_refractive_index);
     void set_shadow(bool n_shadow);
+    void set_absorption(float n_absorption);
     friend bool operator==(const Material &lhs, const Material &rhs);
     friend bool operator!=(const Material &lhs, const Material &rhs);
     Color color_at(const ShapeConstPtr &s, const Tuple &p) const;
     void set_pattern(const PatternPtr &p) {pattern = p;}
     const PatternPtr& get_pattern() const {return pattern;}
     PatternPtr& mod_pattern() {return pattern;};
+    // Replaces a tree of patterns by a PatternProgram, changes to the tree afterwards are not seen
+    void compile_pattern();
 private:
     PatternPtr pattern;
     float ambient;
@@ -43,6 +48,7 @@ private:
     float transparency;
     float refractive_index;
     bool shadow;
+    float absorption;
 };
 
 Material bbox_m();
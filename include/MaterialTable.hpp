@@ -0,0 +1,60 @@
+#ifndef MaterialTable_hpp
+#define MaterialTable_hpp
+
+#include "Material.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+constexpr uint32_t MATERIAL_CHUNK_SIZE = 1024;
+constexpr uint32_t MATERIAL_MAX_CHUNKS = 4096;
+
+// Scene wide storage of materials, shapes refer to them by id. Entries are stored in chunks that never
+// move, so references to them stay valid and reading is safe while other threads add materials.
+// Every entry counts the shapes referring to it: add() returns an id with one reference, and the entry is
+// reset and its id reused once the last reference is released. Id 0 is the default material, it is never
+// counted, changed or freed. Holding more than MATERIAL_CHUNK_SIZE * MATERIAL_MAX_CHUNKS materials at once
+// throws a std::length_error.
+class MaterialTable {
+public:
+    static uint32_t add(const Material &m);
+    static const Material& get(uint32_t id) {
+        return table().chunks[id / MATERIAL_CHUNK_SIZE][id % MATERIAL_CHUNK_SIZE].material;
+    }
+    static Material& mod(uint32_t id);
+    static void acquire(uint32_t id);
+    static void release(uint32_t id);
+    // Whether more than one reference is held, the default material always counts as shared
+    static bool is_shared(uint32_t id);
+    // Number of materials in use, including the default one
+    static uint32_t size();
+    // Compiles the pattern of every material, see Material::compile_pattern()
+    static void compile_patterns();
+private:
+    struct Entry {
+        Material material;
+        std::atomic<uint32_t> references;
+    };
+    struct Table {
+        Table();
+        ~Table();
+        Entry *chunks[MATERIAL_MAX_CHUNKS];
+        // Number of ids ever handed out, the ones in free_ids are among them
+        uint32_t end;
+        std::vector<uint32_t> free_ids;
+        std::mutex mutex;
+    };
+    static Entry& entry(uint32_t id) {
+        return table().chunks[id / MATERIAL_CHUNK_SIZE][id % MATERIAL_CHUNK_SIZE];
+    }
+    // Built on first use, so shapes made while other files are initialized already find the default material.
+    // It is freed at exit.
+    static Table& table() {
+        static Table t;
+        return t;
+    }
+};
+
+#endif /* MaterialTable_hpp */
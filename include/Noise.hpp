@@ -0,0 +1,18 @@
+#ifndef Noise_hpp
+#define Noise_hpp
+
+#include "Tuple.hpp"
+
+constexpr int NOISE_MAX_OCTAVES = 16;
+
+// Improved Perlin noise, https://mrl.cs.nyu.edu/~perlin/noise/, roughly in [-1, 1] and 0 at integer points
+float perlin_noise(const Tuple &p);
+// Noise at 4 points at once
+void perlin_noise4(const float *x, const float *y, const float *z, float *out);
+// Sums of octaves of noise, octave i at frequency lacunarity^i with amplitude gain^i. The octaves are evaluated
+// 4 at a time.
+float fbm(const Tuple &p, int octaves, float lacunarity = 2.0f, float gain = 0.5f);
+// Same as fbm() with the absolute value of every octave
+float turbulence(const Tuple &p, int octaves, float lacunarity = 2.0f, float gain = 0.5f);
+
+#endif /* Noise_hpp */
@@ -39,6 +39,7 @@ public:
     std::shared_ptr<Group> get_group(std::string name) const;
     std::shared_ptr<Group> default_group() const;
     std::shared_ptr<Group> obj_to_group() const;
+    std::shared_ptr<Group> obj_to_group(const BVHOptions &options) const;
     const Tuple vertex(size_t v) const;
     const Tuple normal(size_t v) const;
     const bool valid() const;
@@ -26,6 +26,7 @@ class PatternSolid : public Pattern {
 public:
     PatternSolid(const Color &c);
     Color color_at(const Tuple &p, const ShapeConstPtr &s = nullptr) const override;
+    const Color& get_color() const {return color;}
 private:
     Color color;
 };
@@ -33,6 +34,8 @@ private:
 class PatternBinary : public Pattern {
 public:
     PatternBinary(PatternPtr a, PatternPtr b) : pattern_a(a), pattern_b(b) {}
+    const PatternPtr& get_pattern_a() const {return pattern_a;}
+    const PatternPtr& get_pattern_b() const {return pattern_b;}
 protected:
     Color color_a(const Tuple &p, const ShapeConstPtr &s = nullptr) const;
     Color color_b(const Tuple &p, const ShapeConstPtr &s = nullptr) const;
@@ -83,6 +86,47 @@ public:
     Color color_at(const Tuple &p, const ShapeConstPtr &s = nullptr) const override;
 };
 
+// Blends by fractal noise, a single octave is plain Perlin noise
+class PatternFbm : public PatternBinary {
+public:
+    PatternFbm(const Color &a, const Color &b, int octaves = 4) : PatternFbm(std::make_shared<PatternSolid>(a), std::make_shared<PatternSolid>(b), octaves) {}
+    PatternFbm(PatternPtr a, PatternPtr b, int octaves = 4) : PatternBinary(a, b), octaves_(octaves) {}
+    Color color_at(const Tuple &p, const ShapeConstPtr &s = nullptr) const override;
+private:
+    int octaves_;
+};
+
+class PatternTurbulence : public PatternBinary {
+public:
+    PatternTurbulence(const Color &a, const Color &b, int octaves = 4) : PatternTurbulence(std::make_shared<PatternSolid>(a), std::make_shared<PatternSolid>(b), octaves) {}
+    PatternTurbulence(PatternPtr a, PatternPtr b, int octaves = 4) : PatternBinary(a, b), octaves_(octaves) {}
+    Color color_at(const Tuple &p, const ShapeConstPtr &s = nullptr) const override;
+private:
+    int octaves_;
+};
+
+// Veins along x, bent by turbulence
+class PatternMarble : public PatternBinary {
+public:
+    PatternMarble(const Color &a, const Color &b, int octaves = 4, float distortion = 2.0f) : PatternMarble(std::make_shared<PatternSolid>(a), std::make_shared<PatternSolid>(b), octaves, distortion) {}
+    PatternMarble(PatternPtr a, PatternPtr b, int octaves = 4, float distortion = 2.0f) : PatternBinary(a, b), octaves_(octaves), distortion_(distortion) {}
+    Color color_at(const Tuple &p, const ShapeConstPtr &s = nullptr) const override;
+private:
+    int octaves_;
+    float distortion_;
+};
+
+// Rings around the y axis like PatternRing, fading from a to b within a ring and bent by noise
+class PatternWood : public PatternBinary {
+public:
+    PatternWood(const Color &a, const Color &b, int octaves = 2, float distortion = 0.5f) : PatternWood(std::make_shared<PatternSolid>(a), std::make_shared<PatternSolid>(b), octaves, distortion) {}
+    PatternWood(PatternPtr a, PatternPtr b, int octaves = 2, float distortion = 0.5f) : PatternBinary(a, b), octaves_(octaves), distortion_(distortion) {}
+    Color color_at(const Tuple &p, const ShapeConstPtr &s = nullptr) const override;
+private:
+    int octaves_;
+    float distortion_;
+};
+
 // TODO: Most of the patterns I have use the PatternBinary subclass, however this is not directly applicable here given that it operates on the assumption of 3D points. It delays the transformation of the point with the inverse matrix until a color is picked. Whereas with the UV mapping the point is first transformed to UV space and then passed along to the function to decide on the color. It makes the most sense to transform the point before determining the UV mapping.
 // TODO: Need to figure out a nicer way of doing this
 class PatternUvCheckers : public Pattern {
@@ -0,0 +1,49 @@
+#ifndef PatternProgram_hpp
+#define PatternProgram_hpp
+
+#include "Pattern.hpp"
+
+#include <vector>
+
+enum class PatternOp : uint8_t {
+    Solid,
+    Stripe,
+    Gradient,
+    Ring,
+    Checkers,
+    RadialGradient,
+    Blend,
+    // Patterns the compiler does not know are evaluated through their color_at()
+    Call
+};
+
+// A pattern tree flattened into an array of nodes, evaluated without virtual calls. The transform of every node
+// is composed with those of its ancestors at compile time, so reaching a node costs a single multiplication of
+// the point given to color_at(), or none if the node does not change the space of its parent.
+class PatternProgram : public Pattern {
+public:
+    PatternProgram(const PatternConstPtr &root);
+    Color color_at(const Tuple &p, const ShapeConstPtr &s = nullptr) const override;
+    // Same as color_at() for each point, the points are walked through the program together
+    void colors_at(const Tuple *p, Color *out, size_t n, const ShapeConstPtr &s = nullptr) const;
+    size_t n_nodes() const;
+private:
+    struct Node {
+        PatternOp op;
+        // Whether the node works in the space of its parent, otherwise it transforms the root point with inv
+        bool reuse;
+        uint32_t a, b;
+        Color color;
+        Matrix<4, 4> inv;
+        const Pattern *call;
+    };
+    uint32_t compile(const PatternConstPtr &p, const Matrix<4, 4> &parent_inv, bool root);
+    Color eval(uint32_t i, const Tuple &p0, const Tuple &p, const ShapeConstPtr &s) const;
+    void eval(uint32_t i, const Tuple *p0, const uint32_t *idx, const Tuple *p, size_t n, Color *out, const ShapeConstPtr &s) const;
+    Tuple local(uint32_t i, const Tuple &p0, const Tuple &p) const;
+    std::vector<Node> nodes_;
+    // Keeps the patterns behind Call nodes alive
+    std::vector<PatternConstPtr> calls_;
+};
+
+#endif /* PatternProgram_hpp */
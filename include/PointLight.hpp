@@ -9,6 +9,12 @@ public:
     PointLight(Tuple position, Color intensity);
     float intensity_at(const Tuple &p, const World &w) const override;
     bool operator==(const Light &rhs) const override;
+    // Lets the light fall off with the square of the distance, down to nothing at radius
+    void set_radius(float radius);
+    float range() const override;
+    float attenuation(const Tuple &p) const override;
+private:
+    float radius_;
 };
 
 #endif /* PointLight_hpp */
@@ -0,0 +1,86 @@
+#ifndef Stats_hpp
+#define Stats_hpp
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <typeinfo>
+
+// Render statistics. Counting only happens in builds with RT_STATS defined, otherwise the STATS_ macros
+// compile to nothing. With RT_STATS, counting can still be switched off at runtime with set_enabled().
+// Every thread counts into its own slot of a fixed table, collect() merges the slots, so call it
+// (and reset()) between frames, while no thread is rendering. A slot is freed when its thread exits.
+
+enum class RayKind {Camera, Shadow, Reflection, Refraction, Count};
+
+constexpr int STATS_MAX_THREADS = 256;
+constexpr int STATS_MAX_TYPES = 32;
+
+struct alignas(64) StatsCounters {
+    uint64_t rays[(int) RayKind::Count];
+    uint64_t bounds_tests;
+    // Calls to Shape::intersect, by the slot of the type of the shape
+    uint64_t intersect_tests[STATS_MAX_TYPES];
+    // The same calls without those on groups and BVHs
+    uint64_t primitive_tests;
+    // Nodes of groups and BVHs entered
+    uint64_t node_visits;
+    uint64_t hits;
+    // Sum of the group nesting depth at every intersect call, and the number of calls
+    uint64_t depth_sum;
+    uint64_t depth_samples;
+    uint64_t allocations;
+    uint64_t allocated_bytes;
+    // Shadow rays answered by the occluder cache, and cached occluders that did not block
+    uint64_t occluder_hits;
+    uint64_t occluder_misses;
+    // Depth of the group currently being traversed, not a statistic
+    uint32_t depth;
+};
+
+class Stats {
+public:
+    static void set_enabled(bool enabled);
+    static bool enabled() {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+    // The slot of the calling thread
+    static StatsCounters& local();
+    static StatsCounters collect();
+    static void reset();
+    static int type_slot(const std::type_info &type);
+    static std::string type_name(int slot);
+    static void print(std::ostream &os);
+    static std::string to_json();
+private:
+    static std::atomic<bool> enabled_;
+};
+
+#ifdef RT_STATS
+#define STATS_ADD(field, n) do { if (Stats::enabled()) Stats::local().field += (n); } while (0)
+#define STATS_RAY(kind) STATS_ADD(rays[(int) (kind)], 1)
+#define STATS_BOUNDS_TEST() STATS_ADD(bounds_tests, 1)
+#define STATS_INTERSECT_TEST(shape) do { if (Stats::enabled()) { \
+        StatsCounters &stats_local = Stats::local(); \
+        const int stats_slot = Stats::type_slot(typeid(shape)); \
+        stats_local.intersect_tests[stats_slot]++; \
+        stats_local.primitive_tests += !(shape).is_aggregate(); \
+        stats_local.depth_sum += stats_local.depth; \
+        stats_local.depth_samples++; } } while (0)
+#define STATS_HITS(n) STATS_ADD(hits, n)
+#define STATS_NODE_VISIT() STATS_ADD(node_visits, 1)
+#define STATS_ENTER_GROUP() Stats::local().depth++
+#define STATS_LEAVE_GROUP() Stats::local().depth--
+#else
+#define STATS_ADD(field, n) do {} while (0)
+#define STATS_RAY(kind) do {} while (0)
+#define STATS_BOUNDS_TEST() do {} while (0)
+#define STATS_INTERSECT_TEST(shape) do {} while (0)
+#define STATS_HITS(n) do {} while (0)
+#define STATS_NODE_VISIT() do {} while (0)
+#define STATS_ENTER_GROUP() do {} while (0)
+#define STATS_LEAVE_GROUP() do {} while (0)
+#endif
+
+#endif /* Stats_hpp */
@@ -0,0 +1,42 @@
+#ifndef ThreadPool_hpp
+#define ThreadPool_hpp
+
+#include "concurrentqueue.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Workers pull tasks from a lock-free mpmc queue and sleep while it is empty. The thread calling wait() helps
+// out until all submitted tasks are done, so a pool of n threads spawns n - 1 workers.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned n_threads=std::thread::hardware_concurrency());
+    ~ThreadPool();
+    void submit(std::function<void()> task);
+    // Rethrows the first exception thrown by a task since the last wait()
+    void wait();
+    unsigned size() const;
+    void parallel_for(size_t n, size_t grain, const std::function<void(size_t, size_t)> &f);
+private:
+    bool run_one();
+    void worker();
+    void finish();
+    moodycamel::ConcurrentQueue<std::function<void()>> queue_;
+    std::vector<std::thread> workers_;
+    // Submitted tasks that did not finish yet
+    std::atomic<size_t> pending_;
+    // Tasks in the queue, briefly negative when a task is taken before submit() counted it
+    std::atomic<long> queued_;
+    std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+    std::exception_ptr error_;
+    bool running_;
+};
+
+#endif /* ThreadPool_hpp */
@@ -9,6 +9,8 @@
 #include <vector>
 
 class Ray;
+class LightTree;
+class LightGrid;
 
 class World {
 public:
@@ -22,12 +24,43 @@ public:
     Color color_at(const Ray &r, uint8_t remaining=N_BOUNCE) const;
     Color reflected_color(const IntersectionComp &comps, uint8_t remaining=N_BOUNCE) const;
     Color refracted_color(const IntersectionComp &comps, uint8_t remaining=N_BOUNCE) const;
-    bool is_shadowed(const Tuple &p, const Tuple &light_p) const;
+    // With the occluder cache on, light identifies the light the ray goes to
+    bool is_shadowed(const Tuple &p, const Tuple &light_p, const Light *light=nullptr) const;
     void insert(const ShapePtr &s);
     void insert(const LightPtr &l);
+    // Shades with n_samples lights picked at random from a tree of the lights, in proportion to their
+    // estimated contribution. With n_samples 0 every light is used whose contribution can reach threshold.
+    // Either way the ambient light of every light is added, like without the tree.
+    // Has to be called again after the lights changed.
+    void build_light_tree(int n_samples=0, float threshold=0.0f);
+    void clear_light_tree();
+    // Only shades the lights whose range reaches a point, found through a grid of the lights. Not used
+    // together with a light tree. Has to be called again after the lights changed.
+    void build_light_grid();
+    void clear_light_grid();
+    // Remembers per thread and light the shape that last blocked a shadow ray, and tests it before
+    // anything else. Unlike without the cache, a cached occluder shadows a point even if a shape that casts
+    // no shadow lies in front of it, so scenes with such shapes can render differently with the cache on.
+    void set_occluder_cache(bool enabled);
+    // Lets light through transparent shapes in shadow rays, attenuated by Beer's law
+    void set_transparent_shadows(bool enabled);
+    // The fraction of the light at light_p that reaches p through the transparent shapes in between
+    float transmittance(const Tuple &p, const Tuple &light_p) const;
+    // Either the transmittance or whether p is not shadowed, depending on the transparent shadows
+    float visibility(const Tuple &p, const Tuple &light_p, const Light *light=nullptr) const;
 private:
+    bool blocked_by(const ShapeConstPtr &occluder, const Matrix<4, 4> &to_parent, const Ray &r, float distance) const;
+    Color shade_light(const IntersectionComp &comps, const LightPtr &light) const;
     std::vector<ShapePtr> objects;
     std::vector<LightPtr> lights;
+    std::shared_ptr<LightTree> light_tree;
+    std::shared_ptr<LightGrid> light_grid;
+    int light_samples;
+    float light_threshold;
+    bool occluder_cache;
+    bool transparent_shadows;
+    // Changes whenever the objects may have changed, cached occluders of other versions are not used
+    uint64_t version;
 };
 
 #endif /* World_hpp */
@@ -10,21 +10,31 @@
 class csgOperator : public std::enable_shared_from_this<csgOperator> {
 public:
     virtual bool intersection_allowed(bool lhit, bool inl, bool inr) const = 0;
+    // True if hits on the right operand only count inside the left one, so nothing is left without it
+    virtual bool requires_left() const = 0;
+    // True if hits on the left operand only count inside the right one
+    virtual bool requires_right() const = 0;
 };
 
 class csgUnionOperator : public csgOperator {
 public:
     bool intersection_allowed(bool lhit, bool inl, bool inr) const override;
+    bool requires_left() const override;
+    bool requires_right() const override;
 };
 
 class csgIntersectionOperator : public csgOperator {
 public:
     bool intersection_allowed(bool lhit, bool inl, bool inr) const override;
+    bool requires_left() const override;
+    bool requires_right() const override;
 };
 
 class csgDifferenceOperator : public csgOperator {
 public:
     bool intersection_allowed(bool lhit, bool inl, bool inr) const override;
+    bool requires_left() const override;
+    bool requires_right() const override;
 };
 
 
@@ -37,20 +47,27 @@ public:
         return ret;
     }
     void intersect(const Ray &r, std::vector<Intersection> &xs) const override;
+    void intersect(const Ray &r, std::vector<Intersection> &xs, float tmin, float tmax) const;
     Tuple normal_at_local(const Tuple &p, const Intersection &i) const override;
     void filter_intersections(std::vector<Intersection> &xs) const;
+    void merge_intersections(const std::vector<Intersection> &ls, const std::vector<Intersection> &rs, std::vector<Intersection> &xs) const;
     bool operator==(const Shape &rhs) const override;
     ShapePtr left() const;
     ShapePtr right() const;
     std::shared_ptr<csgOperator> op() const;
     bool includes(const ShapePtr &s) const override;
     void update_bounds();
+    void refit() override;
     void divide(int threshold) override;
 private:
     void init();
+    void intersect_operand(const ShapePtr &s, const CSG *csg, const Ray &r, std::vector<Intersection> &xs, float tmin, float tmax) const;
     std::shared_ptr<csgOperator> op_;
     ShapePtr left_;
     ShapePtr right_;
+    // Operands that are CSGs themselves are passed the interval of the ray that matters
+    const CSG *left_csg_;
+    const CSG *right_csg_;
 };
 
 #endif /* CSG_hpp */
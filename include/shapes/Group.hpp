@@ -3,6 +3,7 @@
 
 #include "Shape.hpp"
 #include "Cube.hpp"
+#include "BVH.hpp"
 
 class Group : public Shape {
 public:
@@ -12,6 +13,7 @@ public:
     Tuple normal_at_local(const Tuple &p, const Intersection &i) const override;
     bool operator==(const Shape &rhs) const override;
     bool includes(const ShapePtr &child) const override;
+    bool is_aggregate() const override;
     void add_child(const ShapePtr &child, bool update=true);
     bool empty() const;
     size_t count() const;
@@ -21,13 +23,27 @@ public:
     template <class... Ts>
     void make_subgroup(Ts const&... args);
     void divide(int threshold) override;
+    void divide(const BVHOptions &options);
     void update_bounds();
+    void refit() override;
+    bool refit_or_rebuild(int threshold, float max_degradation=BVH_MAX_DEGRADATION);
+    float sah_cost() const;
+    void flatten();
     ShapePtr operator[](size_t x) const;
     ShapePtr& operator[](size_t x);
 
     std::shared_ptr<Cube> get_bbox();
     std::vector<ShapePtr> members;
 private:
+    friend class BVHBuilder;
+    template <int N> friend class WideBVH;
+    float node_cost() const;
+    static void remove_duplicates(std::vector<Intersection> &xs, size_t first);
+    // Set on the subgroups created by divide(), these are the only ones flatten() dissolves
+    bool bvh_node_ = false;
+    float build_cost_ = 0.0f;
+    // Spatial splits reference primitives from several leaves, their duplicate hits are removed
+    bool unique_hits_ = false;
 };
 
 template <class... Ts>
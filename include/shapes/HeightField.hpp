@@ -0,0 +1,41 @@
+#ifndef HeightField_hpp
+#define HeightField_hpp
+
+#include "Shape.hpp"
+#include "Ray.hpp"
+#include "Canvas.hpp"
+
+// A terrain over x and z from -1 to 1 whose height y is sampled on a width x depth grid, every cell
+// between four samples made up of two triangles. A mip pyramid of the lowest and highest height in
+// blocks of 2^k cells lets the intersector skip the parts the ray passes above or below, within a block
+// the ray steps through its four children in order. Normals are interpolated from the grid.
+class HeightField : public Shape {
+public:
+    HeightField(uint32_t width, uint32_t depth, const std::vector<float> &heights);
+    // Heights are the mean of the color channels, the rows of the canvas run along z
+    static std::shared_ptr<HeightField> from_canvas(const Canvas &canvas);
+    void intersect(const Ray &r, std::vector<Intersection> &xs) const override;
+    Tuple normal_at_local(const Tuple &p, const Intersection &i) const override;
+    bool operator==(const Shape &rhs) const override;
+    float height(uint32_t x, uint32_t z) const;
+    uint32_t width() const;
+    uint32_t depth() const;
+private:
+    struct Range {
+        float min, max;
+    };
+    struct Level {
+        uint32_t width, depth;
+        std::vector<Range> ranges;
+    };
+    void traverse(const Ray &r, int level, uint32_t i, uint32_t j, float t0, float t1, std::vector<Intersection> &xs) const;
+    void intersect_cell(const Ray &r, uint32_t i, uint32_t j, std::vector<Intersection> &xs) const;
+    Tuple vertex(uint32_t x, uint32_t z) const;
+    Tuple vertex_normal(uint32_t x, uint32_t z) const;
+    uint32_t width_;
+    uint32_t depth_;
+    std::vector<float> heights_;
+    std::vector<Level> levels_;
+};
+
+#endif /* HeightField_hpp */
@@ -0,0 +1,22 @@
+#ifndef Instance_hpp
+#define Instance_hpp
+
+#include "Shape.hpp"
+
+// An instance references a shared, prebuilt prototype (e.g. a divided Group acting as bottom-level
+// acceleration structure) and only carries its own transform and material. Any number of instances
+// can be placed in a Group that is then divided, which acts as the top-level structure.
+// The prototype must not have a parent and instances are not meant to be nested.
+class Instance : public Shape {
+public:
+    Instance(const ShapePtr &prototype);
+    void intersect(const Ray &r, std::vector<Intersection> &xs) const override;
+    Tuple normal_at_local(const Tuple &p, const Intersection &i) const override;
+    bool operator==(const Shape &rhs) const override;
+    void refit() override;
+    ShapePtr prototype() const;
+private:
+    ShapePtr prototype_;
+};
+
+#endif /* Instance_hpp */
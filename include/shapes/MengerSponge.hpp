@@ -5,9 +5,11 @@
 #include "Group.hpp"
 #include "CSG.hpp"
 #include "Cube.hpp"
+#include "Instance.hpp"
 
 std::shared_ptr<CSG> MengerSponge(int m);
 
-std::shared_ptr<Group> MakeCubes(double x1, double y1, double x2, double y2, int n, int max);
+// Every cube is an Instance of one shared unit cube, pass prototype to share it across calls
+std::shared_ptr<Group> MakeCubes(double x1, double y1, double x2, double y2, int n, int max, ShapePtr prototype=nullptr);
 
 #endif /* MengerSponge_hpp */
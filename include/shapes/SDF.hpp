@@ -0,0 +1,73 @@
+#ifndef SDF_hpp
+#define SDF_hpp
+
+#include "Shape.hpp"
+#include "Ray.hpp"
+#include "Helper.hpp"
+
+// A shape given by a signed distance field, negative inside, intersected by sphere tracing within its bounds.
+// Steps are over-relaxed and fall back to plain steps when that skipped past the surface. Both the entries
+// and the exits are reported so refraction and CSG work as for the analytic shapes.
+// Subclasses only provide distance(), which may underestimate the distance but never overestimate it.
+class SDF : public Shape {
+public:
+    SDF(const Bounds &b);
+    virtual float distance(const Tuple &p) const = 0;
+    void intersect(const Ray &r, std::vector<Intersection> &xs) const override;
+    Tuple normal_at_local(const Tuple &p, const Intersection &i) const override;
+    bool operator==(const Shape &rhs) const override;
+    void set_epsilon(float epsilon);
+    void set_max_steps(int max_steps);
+    void set_relaxation(float relaxation);
+protected:
+    float epsilon_;
+    int max_steps_;
+    float relaxation_;
+};
+
+class SDFSphere : public SDF {
+public:
+    SDFSphere();
+    float distance(const Tuple &p) const override;
+};
+
+// The Mandelbulb of the given power, the estimate improves with the iterations
+class SDFMandelbulb : public SDF {
+public:
+    SDFMandelbulb(float power=8.0f, int iterations=12);
+    float distance(const Tuple &p) const override;
+    bool operator==(const Shape &rhs) const override;
+private:
+    float power_;
+    int iterations_;
+};
+
+// A 3D slice at w of the quaternion Julia set of c = (x, y, z, w)
+class SDFJulia : public SDF {
+public:
+    SDFJulia(const Tuple &c, float w=0.0f, int iterations=12);
+    float distance(const Tuple &p) const override;
+    bool operator==(const Shape &rhs) const override;
+private:
+    Tuple c_;
+    float w_;
+    int iterations_;
+};
+
+// Joins two fields with a smooth minimum over a distance of about k, blending spheres gives metaballs.
+// The operands are placed by their own transform which may only scale uniformly.
+class SDFBlend : public SDF {
+public:
+    SDFBlend(const std::shared_ptr<SDF> &a, const std::shared_ptr<SDF> &b, float k);
+    float distance(const Tuple &p) const override;
+    bool operator==(const Shape &rhs) const override;
+private:
+    std::shared_ptr<SDF> a_;
+    std::shared_ptr<SDF> b_;
+    float k_;
+    // Distances in the space of an operand are scaled by its transform
+    float scale_a_;
+    float scale_b_;
+};
+
+#endif /* SDF_hpp */
@@ -5,6 +5,7 @@
 #include "Intersection.hpp"
 #include "Matrix.hpp"
 #include "Material.hpp"
+#include "MaterialTable.hpp"
 #include "Ray.hpp"
 #include "Bounds.hpp"
 
@@ -14,13 +15,24 @@
 class Shape : public std::enable_shared_from_this<Shape> {
 public:
     Shape();
+    Shape(const Shape &s);
+    virtual ~Shape();
+    Shape& operator=(const Shape &s);
     void set_transform(const Matrix<4, 4> &t);
     Matrix<4, 4> const& get_transform() const;
     Matrix<4, 4> const& get_transform_inv() const;
     ShapePtr get_parent();
+    ShapeConstPtr get_parent() const;
     void set_parent(ShapePtr parent_n);
+    // Changes whenever the transform or the parent of any shape changes
+    static uint64_t transform_generation();
     void set_material(const Material &m);
-    const Material& get_material() const;
+    const Material& get_material() const {
+        return MaterialTable::get(material_id);
+    }
+    // Shapes that share a material id share the material until one of them modifies it
+    void set_material_id(uint32_t id);
+    uint32_t get_material_id() const;
     void set_bounds(const Bounds &b);
     Bounds& mod_bounds();
     const Bounds& get_bounds() const;
@@ -32,7 +44,10 @@ public:
     virtual Tuple normal_at_local(const Tuple &p, const Intersection &i) const = 0;
     virtual bool operator==(const Shape &rhs) const = 0;
     virtual void divide(int threshold);
+    virtual void refit();
     virtual bool includes(const ShapePtr &s) const;
+    // Whether the shape only holds other shapes, like groups and BVHs
+    virtual bool is_aggregate() const;
     virtual void UVMappedPoint(const Tuple &p, float *u, float *v) const;
     Bounds bounds_transform;
     Bounds bounds;
@@ -41,8 +56,9 @@ protected:
 private:
     Matrix<4, 4> transform;
     Matrix<4, 4> transform_inv;
-    Material material;
     std::shared_ptr<Shape> parent;
+    // Holds a reference to the entry in the MaterialTable
+    uint32_t material_id;
 };
 
 
@@ -0,0 +1,38 @@
+#ifndef Sponge_hpp
+#define Sponge_hpp
+
+#include "Shape.hpp"
+#include "Ray.hpp"
+#include "Helper.hpp"
+
+// A Menger sponge of the given level filling the cube from -1 to 1, intersected by stepping through
+// the 3x3x3 cells of every level along the ray instead of building it out of cubes, so memory is
+// constant and the work per ray grows with the number of cells the ray passes rather than 20^level.
+// Hits carry the axis of the face that was hit in u and its sign in v.
+class Sponge : public Shape {
+public:
+    Sponge(int level);
+    void intersect(const Ray &r, std::vector<Intersection> &xs) const override;
+    Tuple normal_at_local(const Tuple &p, const Intersection &i) const override;
+    bool operator==(const Shape &rhs) const override;
+    int level() const;
+    static bool is_solid(int ix, int iy, int iz);
+private:
+    struct Span {
+        double t0, t1;
+        int axis0, axis1;
+    };
+    struct Traversal {
+        double o[3];
+        double d[3];
+        int step[3];
+        bool open;
+        Span span;
+    };
+    void traverse(Traversal &tr, const double *lo, double size, int depth, const Span &span, std::vector<Intersection> &xs) const;
+    void add_span(Traversal &tr, const Span &span, std::vector<Intersection> &xs) const;
+    void close_span(Traversal &tr, std::vector<Intersection> &xs) const;
+    int level_;
+};
+
+#endif /* Sponge_hpp */
@@ -0,0 +1,58 @@
+#ifndef WideBVH_hpp
+#define WideBVH_hpp
+
+#include "Shape.hpp"
+#include "Group.hpp"
+
+#include <cstdint>
+
+// A BVH with N children per node, collapsed from the binary hierarchy of a divided Group.
+// The child boxes of a node are quantized to 8 bits relative to the box of the node, so a BVH4 node
+// takes 72 bytes where 4 boxes of floats alone take 96, and all children of a node are tested at once.
+// Only the subgroups of the hierarchy are collapsed, any other shape (including Groups with a
+// transform) is kept as primitive. The transform and material of the group are taken over.
+template <int N>
+class WideBVH : public Shape {
+public:
+    static_assert(N == 4 || N == 8, "Only 4 and 8 wide nodes are supported");
+    WideBVH(const std::shared_ptr<Group> &group);
+    static std::shared_ptr<WideBVH> create(const std::shared_ptr<Group> &group) {
+        std::shared_ptr<WideBVH> ret(std::make_shared<WideBVH>(group));
+        ret->init();
+        return ret;
+    }
+    void intersect(const Ray &r, std::vector<Intersection> &xs) const override;
+    Tuple normal_at_local(const Tuple &p, const Intersection &i) const override;
+    bool operator==(const Shape &rhs) const override;
+    bool includes(const ShapePtr &s) const override;
+    bool is_aggregate() const override;
+    void refit() override;
+    size_t n_nodes() const;
+    size_t n_primitives() const;
+private:
+    struct Node {
+        float origin[3];
+        float scale[3];
+        uint8_t lo[3][N];
+        uint8_t hi[3][N];
+        // Index of the child node, or ~index of the first primitive of a leaf
+        int32_t child[N];
+        uint8_t count[N];
+        uint8_t valid;
+    };
+    void init();
+    int build_node(std::vector<ShapePtr> items, Bounds *box);
+    void quantize(Node &node, const Bounds *boxes, const Bounds &box) const;
+    unsigned hit_mask(const Node &node, const float *o, const float *inv_d) const;
+    void intersect_node(int index, const Ray &r, const float *o, const float *inv_d, std::vector<Intersection> &xs) const;
+    std::vector<Node> nodes_;
+    std::vector<ShapePtr> prims_;
+    // Shapes with infinite bounds such as planes can not be quantized, they are always tested
+    std::vector<ShapePtr> unbounded_;
+    bool unique_hits_;
+};
+
+using BVH4 = WideBVH<4>;
+using BVH8 = WideBVH<8>;
+
+#endif /* WideBVH_hpp */
@@ -1,5 +1,7 @@
 #include "AreaLight.hpp"
 
+#include <algorithm>
+
 AreaLight::AreaLight(Tuple position, Color intensity, Tuple v1, Tuple v2, int usteps, int vsteps) :
       Light(position + (v1 + v2) / 2.0f, intensity),
       corner_(position),
@@ -7,7 +9,8 @@ AreaLight::AreaLight(Tuple position, Color intensity, Tuple v1, Tuple v2, int us
       vvec_(v2 / vsteps),
       usteps_(usteps),
       vsteps_(vsteps),
-      jitter_([](){return 0.5;})
+      jitter_([](){return 0.5;}),
+      adaptive_(false)
 {
     n_samples_ = usteps * vsteps;
 
@@ -19,17 +22,75 @@ AreaLight::AreaLight(Tuple position, Color intensity, Tuple v1, Tuple v2, int us
 }
 
 float AreaLight::intensity_at(const Tuple &p, const World &w) const {
+    if (adaptive_)
+        return adaptive_intensity_at(p, w);
     float total = 0.0;
     for (int v = 0; v < vsteps_; v++) {
         for (int u = 0; u < usteps_; u++) {
             Tuple light_p = point_on_light(u, v);
-            if (!w.is_shadowed(p, light_p))
-                total += 1.0;
+            total += w.visibility(p, light_p, this);
         }
     }
     return total / n_samples_;
 }
 
+float AreaLight::adaptive_intensity_at(const Tuple &p, const World &w) const {
+    // Visibility of every cell of the grid, -1 while it is not known, reused between calls
+    thread_local std::vector<float> visible;
+    visible.assign(n_samples_, -1.0f);
+    return adaptive_lit(p, w, 0, 0, usteps_, vsteps_, visible) / n_samples_;
+}
+
+// Returns the summed visibility of the cells in [u0, u1) x [v0, v1). Regions whose corners and centre all
+// see as much of the light count as such, others are split in four. Samples shared by regions are cast only once.
+float AreaLight::adaptive_lit(const Tuple &p, const World &w, int u0, int v0, int u1, int v1, std::vector<float> &visible) const {
+    auto lit = [&](int u, int v) {
+        float &cell = visible[v * usteps_ + u];
+        if (cell < 0.0f)
+            cell = w.visibility(p, point_on_light(u, v), this);
+        return cell;
+    };
+
+    const int area = (u1 - u0) * (v1 - v0);
+    const float probes[] = {lit(u0, v0), lit(u1 - 1, v0), lit(u0, v1 - 1), lit(u1 - 1, v1 - 1),
+                            lit((u0 + u1) / 2, (v0 + v1) / 2)};
+    if (std::all_of(probes + 1, probes + 5, [&](float x) { return x == probes[0]; }))
+        return area * probes[0];
+
+    // Small regions have been sampled almost completely already
+    if (u1 - u0 <= 2 && v1 - v0 <= 2) {
+        float total = 0.0f;
+        for (int v = v0; v < v1; v++)
+            for (int u = u0; u < u1; u++)
+                total += lit(u, v);
+        return total;
+    }
+    const int um = (u0 + u1 + 1) / 2, vm = (v0 + v1 + 1) / 2;
+    if (v1 - v0 == 1)
+        return adaptive_lit(p, w, u0, v0, um, v1, visible) + adaptive_lit(p, w, um, v0, u1, v1, visible);
+    if (u1 - u0 == 1)
+        return adaptive_lit(p, w, u0, v0, u1, vm, visible) + adaptive_lit(p, w, u0, vm, u1, v1, visible);
+    return adaptive_lit(p, w, u0, v0, um, vm, visible) + adaptive_lit(p, w, um, v0, u1, vm, visible) +
+           adaptive_lit(p, w, u0, vm, um, v1, visible) + adaptive_lit(p, w, um, vm, u1, v1, visible);
+}
+
+Tuple AreaLight::sample_point(size_t i) const {
+    return point_on_light(i % usteps_, i / usteps_);
+}
+
+// Adaptive sampling only estimates the fraction of the light that is visible
+bool AreaLight::shade_per_sample() const {
+    return !adaptive_;
+}
+
+Bounds AreaLight::bounds() const {
+    Bounds b = Bounds(corner_, corner_);
+    b.update(corner_ + uvec_ * usteps_);
+    b.update(corner_ + vvec_ * vsteps_);
+    b.update(corner_ + uvec_ * usteps_ + vvec_ * vsteps_);
+    return b;
+}
+
 Tuple AreaLight::point_on_light(float u, float v) const {
     return corner_ +
            uvec_ * (u + jitter_by()) +
@@ -69,3 +130,11 @@ float AreaLight::jitter_by() const {
 void AreaLight::set_jitter(std::function<float()> f) {
     jitter_ = f;
 }
+
+void AreaLight::set_adaptive(bool adaptive) {
+    adaptive_ = adaptive;
+}
+
+bool AreaLight::adaptive() const {
+    return adaptive_;
+}
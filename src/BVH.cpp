@@ -0,0 +1,510 @@
+#include "BVH.hpp"
+#include "Group.hpp"
+#include "ThreadPool.hpp"
+#include "Triangle.hpp"
+#include "SmoothTriangle.hpp"
+
+#include <chrono>
+#include <mutex>
+
+// Number of buckets the centroids are binned into when evaluating SAH splits
+constexpr int N_BINS = 12;
+// Ranges smaller than this are binned on a single thread
+constexpr size_t PARALLEL_BINNING_MIN = 4096;
+// Spatial splits can keep producing children that hold all references, stop at this depth
+constexpr int SPATIAL_MAX_DEPTH = 64;
+
+// Spreads the lower 10 bits of v so that there are two zero bits between each of them
+static uint32_t expand_bits(uint32_t v) {
+    v = (v * 0x00010001u) & 0xFF0000FFu;
+    v = (v * 0x00000101u) & 0x0F00F00Fu;
+    v = (v * 0x00000011u) & 0xC30C30C3u;
+    v = (v * 0x00000005u) & 0x49249249u;
+    return v;
+}
+
+static uint32_t morton_code(const Tuple &p) {
+    const uint32_t x = (uint32_t) fclamp(p[0] * 1024.0f, 0.0f, 1023.0f);
+    const uint32_t y = (uint32_t) fclamp(p[1] * 1024.0f, 0.0f, 1023.0f);
+    const uint32_t z = (uint32_t) fclamp(p[2] * 1024.0f, 0.0f, 1023.0f);
+    return (expand_bits(x) << 2) | (expand_bits(y) << 1) | expand_bits(z);
+}
+
+static int common_prefix(uint32_t a, uint32_t b) {
+    return a == b ? 32 : __builtin_clz(a ^ b);
+}
+
+static int largest_axis(const Bounds &b) {
+    const Tuple d = b.max() - b.min();
+    if (d[0] >= d[1] && d[0] >= d[2])
+        return 0;
+    return d[1] >= d[2] ? 1 : 2;
+}
+
+// Returns the overlap of two boxes, which is empty if they do not overlap
+static Bounds overlap(const Bounds &a, const Bounds &b) {
+    const Tuple min = a.min().max(b.min());
+    const Tuple max = a.max().min(b.max());
+    if (min[0] > max[0] || min[1] > max[1] || min[2] > max[2])
+        return Bounds();
+    return Bounds(min, max);
+}
+
+// Triangles are clipped exactly by spatial splits, other shapes only by their bounds
+static bool triangle_vertices(const ShapePtr &s, Tuple *v) {
+    if (const Triangle *t = dynamic_cast<const Triangle*>(s.get())) {
+        v[0] = t->p1(); v[1] = t->p2(); v[2] = t->p3();
+    } else if (const SmoothTriangle *t = dynamic_cast<const SmoothTriangle*>(s.get())) {
+        v[0] = t->p1(); v[1] = t->p2(); v[2] = t->p3();
+    } else {
+        return false;
+    }
+    for (int i = 0; i < 3; i++)
+        v[i] = s->get_transform() * v[i];
+    return true;
+}
+
+BVHBuilder::BVHBuilder(const BVHOptions &options) :
+    options_(options),
+    spawn_depth_(0),
+    n_references_(0),
+    max_references_(0),
+    root_area_(0.0f),
+    build_ms_(0.0)
+{
+    options_.threshold = std::max(options_.threshold, 1);
+    options_.n_threads = std::max(options_.n_threads, 1u);
+}
+
+double BVHBuilder::build_ms() const {
+    return build_ms_;
+}
+
+size_t BVHBuilder::n_references() const {
+    return n_references_;
+}
+
+// The pool is made once and shared by the hierarchies of all nested groups. Spatial splits are built on
+// the calling thread and get no pool.
+void BVHBuilder::build(Group &root) {
+    const auto start = std::chrono::steady_clock::now();
+    std::unique_ptr<ThreadPool> pool;
+    if (options_.n_threads > 1 && options_.method != BVHMethod::Spatial)
+        pool = std::make_unique<ThreadPool>(options_.n_threads);
+    n_references_ = 0;
+    const size_t n_prims = build(root, pool.get());
+
+    build_ms_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (options_.log) {
+        const char *names[] = {"Midpoint", "SAH", "Morton", "Spatial"};
+        std::cout << "BVH (" << names[(int) options_.method] << "): " << n_prims << " primitives, "
+                  << n_references_ << " references, "
+                  << (pool ? pool->size() : 1) << " threads, " << build_ms_ << " ms" << std::endl;
+    }
+}
+
+// Returns the number of primitives of root, n_references_ is left at the number of references to them
+size_t BVHBuilder::build(Group &root, ThreadPool *pool) {
+    // Nested groups are treated as primitives, but get their own hierarchy first
+    for (auto &child : root.members) {
+        const std::shared_ptr<Group> subgroup = std::dynamic_pointer_cast<Group>(child);
+        if (subgroup)
+            build(*subgroup, pool);
+        else
+            child->divide(options_.threshold);
+    }
+
+    if (root.count() <= (size_t) options_.threshold) {
+        root.update_bounds();
+        n_references_ = root.count();
+        return root.count();
+    }
+
+    prims_.clear();
+    prims_.reserve(root.count());
+    for (auto &child : root.members) {
+        const Bounds &b = child->bounds_transform;
+        prims_.push_back({child, b, (b.min() + b.max()) * 0.5f, 0});
+    }
+    root.members.clear();
+
+    // Hand out four subtrees per thread to even out the load
+    spawn_depth_ = pool ? (int) std::ceil(std::log2(options_.n_threads)) + 2 : 0;
+
+    if (options_.method == BVHMethod::Morton)
+        compute_morton(pool);
+
+    deferred_.clear();
+    upper_.clear();
+    const size_t n_prims = prims_.size();
+    n_references_ = n_prims;
+    if (options_.method == BVHMethod::Spatial) {
+        max_references_ = n_prims + (size_t) (n_prims * std::max(options_.max_duplication, 0.0f));
+        root_area_ = root.bounds.surface_area();
+        std::vector<Primitive> refs;
+        refs.swap(prims_);
+        build_spatial(root, refs, 0);
+        // A primitive referenced by several leaves can be hit more than once
+        root.unique_hits_ = n_references_ > n_prims;
+    } else {
+        build_node(root, 0, prims_.size(), 0, pool);
+    }
+
+    for (const Task &task : deferred_) {
+        BVHBuilder *builder = this;
+        pool->submit([builder, task]() { builder->build_node(*task.node, task.begin, task.end, 0, nullptr); });
+    }
+    if (pool)
+        pool->wait();
+
+    // The upper nodes were recorded after their children, so their bounds can be fixed in order
+    for (Group *node : upper_)
+        node->update_bounds();
+    root.build_cost_ = root.sah_cost();
+    prims_.clear();
+    return n_prims;
+}
+
+void BVHBuilder::build_node(Group &node, size_t begin, size_t end, int depth, ThreadPool *pool) {
+    if (end - begin <= (size_t) options_.threshold) {
+        for (size_t i = begin; i < end; i++)
+            node.add_child(prims_[i].shape, false);
+        node.update_bounds();
+        return;
+    }
+
+    const size_t mid = split(begin, end, pool);
+    const size_t ranges[2][2] = {{begin, mid}, {mid, end}};
+    for (const auto &range : ranges) {
+        const std::shared_ptr<Group> child = std::make_shared<Group>();
+        child->bvh_node_ = true;
+        node.add_child(child, false);
+        // Subtrees below the spawn depth are independent and built by the pool once the upper levels are done
+        if (pool && depth + 1 >= spawn_depth_)
+            deferred_.push_back({child, range[0], range[1]});
+        else
+            build_node(*child, range[0], range[1], depth + 1, pool);
+    }
+
+    if (pool)
+        upper_.push_back(&node);
+    else
+        node.update_bounds();
+}
+
+Bounds BVHBuilder::centroid_bounds(size_t begin, size_t end) const {
+    Bounds b;
+    for (size_t i = begin; i < end; i++)
+        b.update(prims_[i].centroid);
+    return b;
+}
+
+size_t BVHBuilder::split(size_t begin, size_t end, ThreadPool *pool) {
+    const Bounds centroids = centroid_bounds(begin, end);
+    size_t mid = begin;
+    switch (options_.method) {
+        case BVHMethod::Midpoint:
+            mid = split_midpoint(begin, end, centroids);
+            break;
+        case BVHMethod::SAH:
+        case BVHMethod::Spatial:
+            mid = split_sah(begin, end, centroids, pool);
+            break;
+        case BVHMethod::Morton:
+            mid = split_morton(begin, end);
+            break;
+    }
+    // Degenerate splits, e.g. all centroids coincide, fall back to splitting the range in half
+    if (mid == begin || mid == end)
+        mid = split_median(begin, end, centroids);
+    return mid;
+}
+
+size_t BVHBuilder::split_median(size_t begin, size_t end, const Bounds &centroids) {
+    const int axis = largest_axis(centroids);
+    const size_t mid = begin + (end - begin) / 2;
+    std::nth_element(prims_.begin() + begin, prims_.begin() + mid, prims_.begin() + end,
+                     [axis](const Primitive &a, const Primitive &b) { return a.centroid[axis] < b.centroid[axis]; });
+    return mid;
+}
+
+size_t BVHBuilder::split_midpoint(size_t begin, size_t end, const Bounds &centroids) {
+    const int axis = largest_axis(centroids);
+    const float pmid = (centroids.min()[axis] + centroids.max()[axis]) * 0.5f;
+    auto it = std::partition(prims_.begin() + begin, prims_.begin() + end,
+                             [axis, pmid](const Primitive &p) { return p.centroid[axis] < pmid; });
+    return it - prims_.begin();
+}
+
+size_t BVHBuilder::split_sah(size_t begin, size_t end, const Bounds &centroids, ThreadPool *pool,
+                             float *cost, Bounds *left, Bounds *right) {
+    const int axis = largest_axis(centroids);
+    const float cmin = centroids.min()[axis];
+    const float extent = centroids.max()[axis] - cmin;
+    if (extent <= 0.0f)
+        return begin;
+
+    struct Bin {
+        Bounds bounds;
+        size_t count = 0;
+    };
+    auto bin_of = [axis, cmin, extent](const Primitive &p) {
+        return std::min(N_BINS - 1, (int) (N_BINS * ((p.centroid[axis] - cmin) / extent)));
+    };
+
+    Bin bins[N_BINS];
+    auto fill = [this, &bin_of](size_t b, size_t e, Bin *out) {
+        for (size_t i = b; i < e; i++) {
+            Bin &bin = out[bin_of(prims_[i])];
+            bin.bounds.merge(prims_[i].bounds);
+            bin.count++;
+        }
+    };
+    if (pool && end - begin >= PARALLEL_BINNING_MIN) {
+        std::mutex m;
+        pool->parallel_for(end - begin, PARALLEL_BINNING_MIN / 4, [&](size_t b, size_t e) {
+            Bin local[N_BINS];
+            fill(begin + b, begin + e, local);
+            std::lock_guard<std::mutex> lock(m);
+            for (int i = 0; i < N_BINS; i++) {
+                bins[i].bounds.merge(local[i].bounds);
+                bins[i].count += local[i].count;
+            }
+        });
+    } else {
+        fill(begin, end, bins);
+    }
+
+    // Sweep from the right to get the cost of all the right sides, then from the left to find the best plane
+    float right_area[N_BINS];
+    size_t right_count[N_BINS];
+    Bounds acc;
+    size_t count = 0;
+    for (int i = N_BINS - 1; i > 0; i--) {
+        acc.merge(bins[i].bounds);
+        count += bins[i].count;
+        right_area[i] = acc.surface_area();
+        right_count[i] = count;
+    }
+
+    int best = -1;
+    float best_cost = INF;
+    acc = Bounds();
+    count = 0;
+    for (int i = 0; i < N_BINS - 1; i++) {
+        acc.merge(bins[i].bounds);
+        count += bins[i].count;
+        const float c = acc.surface_area() * count + right_area[i + 1] * right_count[i + 1];
+        if (count > 0 && right_count[i + 1] > 0 && c < best_cost) {
+            best_cost = c;
+            best = i;
+        }
+    }
+    if (best < 0)
+        return begin;
+
+    if (cost) {
+        *cost = best_cost;
+        *left = Bounds();
+        *right = Bounds();
+        for (int i = 0; i < N_BINS; i++)
+            (i <= best ? left : right)->merge(bins[i].bounds);
+    }
+
+    auto it = std::partition(prims_.begin() + begin, prims_.begin() + end,
+                             [&bin_of, best](const Primitive &p) { return bin_of(p) <= best; });
+    return it - prims_.begin();
+}
+
+void BVHBuilder::compute_morton(ThreadPool *pool) {
+    const Bounds centroids = centroid_bounds(0, prims_.size());
+    const Tuple cmin = centroids.min();
+    const Tuple extent = centroids.max() - cmin;
+    auto encode = [this, &cmin, &extent](size_t b, size_t e) {
+        for (size_t i = b; i < e; i++) {
+            Tuple p = prims_[i].centroid - cmin;
+            for (int a = 0; a < 3; a++)
+                p[a] = extent[a] > 0.0f ? p[a] / extent[a] : 0.0f;
+            prims_[i].morton = morton_code(p);
+        }
+    };
+    if (pool)
+        pool->parallel_for(prims_.size(), PARALLEL_BINNING_MIN, encode);
+    else
+        encode(0, prims_.size());
+    std::sort(prims_.begin(), prims_.end(), [](const Primitive &a, const Primitive &b) { return a.morton < b.morton; });
+}
+
+// The primitives are sorted by code, split where the highest bit that differs within the range flips
+size_t BVHBuilder::split_morton(size_t begin, size_t end) {
+    const uint32_t first = prims_[begin].morton;
+    const uint32_t last = prims_[end - 1].morton;
+    if (first == last)
+        return begin;
+    const int prefix = common_prefix(first, last);
+
+    size_t lo = begin, hi = end - 1;
+    while (lo + 1 < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        if (common_prefix(first, prims_[mid].morton) > prefix)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return hi;
+}
+
+// Restricts a reference to the slab [lo, hi] along axis, returns false if nothing of it is left
+bool BVHBuilder::clip(const Primitive &ref, int axis, float lo, float hi, Primitive *out) const {
+    Bounds b;
+    Tuple v[3];
+    if (triangle_vertices(ref.shape, v)) {
+        // Bounds of the part of the triangle within the slab: its vertices inside and its edges crossing a plane
+        for (int i = 0; i < 3; i++) {
+            const Tuple &p = v[i];
+            const Tuple &q = v[(i + 1) % 3];
+            if (p[axis] >= lo && p[axis] <= hi)
+                b.update(p);
+            for (const float plane : {lo, hi}) {
+                if ((p[axis] < plane && q[axis] > plane) || (p[axis] > plane && q[axis] < plane)) {
+                    const float t = (plane - p[axis]) / (q[axis] - p[axis]);
+                    Tuple x = p + (q - p) * t;
+                    x[axis] = plane;
+                    b.update(x);
+                }
+            }
+        }
+        b = overlap(b, ref.bounds);
+    } else {
+        Tuple min = ref.bounds.min(), max = ref.bounds.max();
+        min[axis] = std::max(min[axis], lo);
+        max[axis] = std::min(max[axis], hi);
+        b = min[axis] <= max[axis] ? Bounds(min, max) : Bounds();
+    }
+    if (b.min()[0] > b.max()[0])
+        return false;
+    *out = {ref.shape, b, (b.min() + b.max()) * 0.5f, 0};
+    return true;
+}
+
+// Bins the references along each axis, clipping them to every bin they span, and returns the cheapest plane
+bool BVHBuilder::find_spatial_split(const std::vector<Primitive> &refs, const Bounds &node_bounds, int *axis, float *plane, float *cost) const {
+    bool found = false;
+    *cost = INF;
+    for (int a = 0; a < 3; a++) {
+        const float lo = node_bounds.min()[a];
+        const float extent = node_bounds.max()[a] - lo;
+        if (extent <= 0.0f)
+            continue;
+        const float width = extent / N_BINS;
+        auto bin_of = [lo, width](float x) {
+            return std::clamp((int) ((x - lo) / width), 0, N_BINS - 1);
+        };
+
+        Bounds bins[N_BINS];
+        size_t entries[N_BINS] = {0};
+        size_t exits[N_BINS] = {0};
+        for (const Primitive &ref : refs) {
+            const int first = bin_of(ref.bounds.min()[a]);
+            const int last = bin_of(ref.bounds.max()[a]);
+            for (int i = first; i <= last; i++) {
+                Primitive part;
+                if (clip(ref, a, lo + i * width, lo + (i + 1) * width, &part))
+                    bins[i].merge(part.bounds);
+            }
+            entries[first]++;
+            exits[last]++;
+        }
+
+        float right_area[N_BINS];
+        size_t right_count[N_BINS];
+        Bounds acc;
+        size_t count = 0;
+        for (int i = N_BINS - 1; i > 0; i--) {
+            acc.merge(bins[i]);
+            count += exits[i];
+            right_area[i] = acc.surface_area();
+            right_count[i] = count;
+        }
+        acc = Bounds();
+        count = 0;
+        for (int i = 0; i < N_BINS - 1; i++) {
+            acc.merge(bins[i]);
+            count += entries[i];
+            const float c = acc.surface_area() * count + right_area[i + 1] * right_count[i + 1];
+            if (count > 0 && right_count[i + 1] > 0 && c < *cost) {
+                *cost = c;
+                *axis = a;
+                *plane = lo + (i + 1) * width;
+                found = true;
+            }
+        }
+    }
+    return found;
+}
+
+void BVHBuilder::build_spatial(Group &node, std::vector<Primitive> &refs, int depth) {
+    if (refs.size() <= (size_t) options_.threshold || depth >= SPATIAL_MAX_DEPTH) {
+        // The box of a leaf only covers the clipped parts of its references. A primitive in several leaves gets
+        // the last one as parent, the leaves have no transform of their own so any of them would do.
+        Bounds box;
+        for (const Primitive &ref : refs) {
+            node.add_child(ref.shape, false);
+            box.merge(ref.bounds);
+        }
+        node.bounds = box;
+        node.bounds_transform = box * node.get_transform();
+        return;
+    }
+
+    // The object split is evaluated in place on the shared buffer
+    prims_.swap(refs);
+    const size_t n = prims_.size();
+    const Bounds centroids = centroid_bounds(0, n);
+    Bounds node_bounds, left_b, right_b;
+    for (const Primitive &ref : prims_)
+        node_bounds.merge(ref.bounds);
+    float object_cost = INF;
+    size_t mid = split_sah(0, n, centroids, nullptr, &object_cost, &left_b, &right_b);
+    if (mid == 0 || mid == n) {
+        mid = split_median(0, n, centroids);
+        object_cost = INF;
+    }
+
+    std::vector<Primitive> left, right;
+    int axis = 0;
+    float plane = 0.0f, spatial_cost = INF;
+    const bool try_spatial = n_references_ < max_references_ &&
+                             overlap(left_b, right_b).surface_area() > options_.spatial_alpha * root_area_;
+    if (try_spatial && find_spatial_split(prims_, node_bounds, &axis, &plane, &spatial_cost) && spatial_cost < object_cost) {
+        for (const Primitive &ref : prims_) {
+            Primitive l, r;
+            const bool in_left = clip(ref, axis, -INF, plane, &l);
+            const bool in_right = clip(ref, axis, plane, INF, &r);
+            if (in_left && in_right && n_references_ < max_references_) {
+                left.push_back(l);
+                right.push_back(r);
+                n_references_++;
+            } else if (in_left && (!in_right || ref.centroid[axis] < plane)) {
+                // Out of budget, the whole reference goes to the side its centroid is on
+                left.push_back(ref);
+            } else {
+                right.push_back(ref);
+            }
+        }
+    }
+    if (left.empty() || right.empty()) {
+        left.assign(prims_.begin(), prims_.begin() + mid);
+        right.assign(prims_.begin() + mid, prims_.end());
+    }
+    prims_.clear();
+
+    for (std::vector<Primitive> *side : {&left, &right}) {
+        const std::shared_ptr<Group> child = std::make_shared<Group>();
+        child->bvh_node_ = true;
+        node.add_child(child, false);
+        build_spatial(*child, *side, depth + 1);
+    }
+    // The children are the clipped boxes of the subtrees
+    node.update_bounds();
+}
@@ -1,4 +1,5 @@
 #include "Bounds.hpp"
+#include "Stats.hpp"
 
 Bounds::Bounds() :
     min_(Point(INF, INF, INF)),
@@ -128,6 +129,7 @@ Bounds operator*(const Bounds &b, const Matrix<4, 4> &m) {
 // Should be able to handle the special case, not as consistently, faster
 // 83.58s
 bool Bounds::intersects(const Ray &r) const {
+    STATS_BOUNDS_TEST();
     Tuple o = r.get_origin();
     Tuple d = Vector(1.0/r.get_direction().get_x(),
                      1.0/r.get_direction().get_y(),
@@ -161,6 +163,33 @@ bool Bounds::intersects(const Ray &r) const {
 //    return tmax >= 0.0f && tmin <= tmax;  // Includes both test for checking behind and for intersection
 //}
 
+// Returns the interval of the ray inside the box, not limited to positive distances
+bool Bounds::intersects(const Ray &r, float *t0, float *t1) const {
+    STATS_BOUNDS_TEST();
+    Tuple o = r.get_origin();
+    Tuple d = Vector(1.0/r.get_direction().get_x(),
+                     1.0/r.get_direction().get_y(),
+                     1.0/r.get_direction().get_z());
+
+    double tmin = -INF, tmax = INF;
+    for (int i = 0; i < 3; i++) {
+        const double t1 = (min_[i] - o[i]) * d[i];
+        const double t2 = (max_[i] - o[i]) * d[i];
+        tmin = std::max(tmin, std::min(t1, t2));
+        tmax = std::min(tmax, std::max(t1, t2));
+    }
+    *t0 = tmin;
+    *t1 = tmax;
+    return tmin <= tmax;
+}
+
+float Bounds::surface_area() const {
+    if (min_.get_x() > max_.get_x())
+        return 0.0f;
+    const Tuple d = max_ - min_;
+    return 2.0f * (d.get_x() * d.get_y() + d.get_y() * d.get_z() + d.get_z() * d.get_x());
+}
+
 void Bounds::split_bounds(Bounds *left, Bounds *right) const {
     const float dx = max_.get_x() - min_.get_x();
     const float dy = max_.get_y() - min_.get_y();
@@ -1,4 +1,10 @@
 #include "Camera.hpp"
+#include "Stats.hpp"
+#include "ThreadPool.hpp"
+
+#include <chrono>
+#include <functional>
+#include <stdexcept>
 
 Camera::Camera(uint32_t hsize, uint32_t vsize, float fov) :
     hsize(hsize),
@@ -58,14 +64,67 @@ Ray Camera::ray_for_pixel(uint32_t px, uint32_t py) const {
     const Tuple pixel = transform_inv * Point(world_x, world_y, -1.0);
     const Tuple origin = transform_inv * Point(0, 0, 0);
     const Tuple direction = (pixel - origin).normalize();
+    STATS_RAY(RayKind::Camera);
     return Ray(origin, direction);
 }
 
+// Rows are independent, with more than one thread every row is a task, so that expensive parts of the
+// image are spread over the threads
+static void for_rows(uint32_t vsize, unsigned n_threads, const std::function<void(uint32_t, uint32_t)> &f) {
+    if (n_threads > 1) {
+        ThreadPool pool(n_threads);
+        for (uint32_t y = 0; y < vsize; y++)
+            pool.submit([&f, y]() { f(y, y + 1); });
+        pool.wait();
+    } else {
+        f(0, vsize);
+    }
+}
+
 // TODO: Gamma correction: https://news.ycombinator.com/item?id=13563577
-Canvas Camera::render(const World &w, uint32_t samples) const {
+Canvas Camera::render(const World &w, uint32_t samples, unsigned n_threads) const {
     Canvas image = Canvas(hsize, vsize);
+    for_rows(vsize, n_threads, [&](uint32_t begin, uint32_t end) { render_rows(w, samples, begin, end, image); });
+    return image;
+}
+
+GBuffer Camera::capture(const World &w, unsigned n_threads) const {
+    GBuffer g = GBuffer(hsize, vsize);
+    for_rows(vsize, n_threads, [&](uint32_t begin, uint32_t end) {
+        std::vector<Intersection> xs;
+        for (uint32_t y = begin; y < end; y++) {
+            for (uint32_t x = 0; x < hsize; x++) {
+                const Ray r = ray_for_pixel(x, y);
+                xs.clear();
+                r.intersect(w, xs);
+                const Intersection hit = Hit(xs);
+                if (hit.get_shape() != nullptr)
+                    g.write_hit(x, y, r.prepare_computations(hit, xs));
+            }
+        }
+    });
+    return g;
+}
+
+// Only the shading is redone, including the shadow, reflected and refracted rays
+Canvas Camera::render(const World &w, const GBuffer &g, unsigned n_threads) const {
+    if (g.get_width() != hsize || g.get_height() != vsize)
+        throw std::runtime_error("The G-buffer was captured at another resolution than the camera's!");
+    Canvas image = Canvas(hsize, vsize);
+    for_rows(vsize, n_threads, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t y = begin; y < end; y++) {
+            for (uint32_t x = 0; x < hsize; x++) {
+                const IntersectionComp *comps = g.get_hit(x, y);
+                image.write_pixel(x, y, comps ? w.shade_hit(*comps) : Color(0.0f, 0.0f, 0.0f));
+            }
+        }
+    });
+    return image;
+}
+
+void Camera::render_rows(const World &w, uint32_t samples, uint32_t begin, uint32_t end, Canvas &image) const {
     if (samples <= 1) {
-        for (uint32_t y = 0; y < vsize; y++) {
+        for (uint32_t y = begin; y < end; y++) {
             for (uint32_t x = 0; x < hsize; x++) {
                 const Ray r = ray_for_pixel(x, y);
                 Color c = w.color_at(r);
@@ -87,7 +146,7 @@ Canvas Camera::render(const World &w, uint32_t samples) const {
         }
     } else {
         auto scale = 1.0 / samples;
-        for (uint32_t y = 0; y < vsize; y++) {
+        for (uint32_t y = begin; y < end; y++) {
             for (uint32_t x = 0; x < hsize; x++) {
                 Color c = Color(0, 0, 0);
                 for (uint32_t s = 0; s <= samples; s++) {
@@ -102,6 +161,50 @@ Canvas Camera::render(const World &w, uint32_t samples) const {
             }
         }
     }
+}
+
+Color heat_color(float t) {
+    static const Color stops[] = {Color(0, 0, 1), Color(0, 1, 1), Color(0, 1, 0), Color(1, 1, 0), Color(1, 0, 0)};
+    t = std::clamp(t, 0.0f, 1.0f) * 4.0f;
+    const int i = std::min((int) t, 3);
+    return stops[i] + (stops[i + 1] - stops[i]) * (t - i);
+}
+
+static uint64_t metric_value(const StatsCounters &stats, HeatmapMetric metric) {
+    return metric == HeatmapMetric::NodeVisits ? stats.node_visits : stats.primitive_tests;
+}
+
+// Renders a frame like render() does, but shows the cost of every pixel scaled to the most expensive one.
+// The raw costs are stored in values if given, row by row.
+// Without RT_STATS the counters stay at 0, so only the time can be shown.
+Canvas Camera::render_heatmap(const World &w, HeatmapMetric metric, std::vector<double> *values) const {
+#ifndef RT_STATS
+    if (metric != HeatmapMetric::Time)
+        throw std::runtime_error("A heatmap of node visits or primitive tests needs a build with RT_STATS!");
+#endif
+    std::vector<double> cost(hsize * vsize);
+    for (uint32_t y = 0; y < vsize; y++) {
+        for (uint32_t x = 0; x < hsize; x++) {
+            if (metric == HeatmapMetric::Time) {
+                const auto start = std::chrono::steady_clock::now();
+                w.color_at(ray_for_pixel(x, y));
+                cost[y * hsize + x] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            } else {
+                const uint64_t before = metric_value(Stats::local(), metric);
+                w.color_at(ray_for_pixel(x, y));
+                cost[y * hsize + x] = metric_value(Stats::local(), metric) - before;
+            }
+        }
+    }
+
+    const double max_cost = *std::max_element(cost.begin(), cost.end());
+    Canvas image = Canvas(hsize, vsize);
+    for (uint32_t y = 0; y < vsize; y++) {
+        for (uint32_t x = 0; x < hsize; x++)
+            image.write_pixel(x, y, heat_color(max_cost > 0.0 ? cost[y * hsize + x] / max_cost : 0.0f));
+    }
+    if (values)
+        *values = std::move(cost);
     return image;
 }
 
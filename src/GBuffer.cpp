@@ -0,0 +1,28 @@
+#include "GBuffer.hpp"
+
+GBuffer::GBuffer(uint32_t width, uint32_t height) :
+    width(width),
+    height(height),
+    hits(width * height)
+{}
+
+uint32_t GBuffer::get_width() const {
+    return width;
+}
+
+uint32_t GBuffer::get_height() const {
+    return height;
+}
+
+const IntersectionComp* GBuffer::get_hit(uint32_t x, uint32_t y) const {
+    if (x >= width || y >= height)
+        return nullptr;
+    const IntersectionComp &comps = hits[x + width * y];
+    return comps.object ? &comps : nullptr;
+}
+
+void GBuffer::write_hit(uint32_t x, uint32_t y, const IntersectionComp &comps) {
+    if (x >= width || y >= height)
+        return;
+    hits[x + width * y] = comps;
+}
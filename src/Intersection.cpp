@@ -4,6 +4,9 @@ Intersection::Intersection(float distance, ShapeConstPtr const& s) : distance{di
 
 Intersection::Intersection(float distance, ShapeConstPtr const& s, float u, float v) : distance{distance}, shape{s}, u_(u), v_(v) {}
 
+// Re-targets a hit found inside a shared structure to the instance that references it
+Intersection::Intersection(const Intersection &i, ShapeConstPtr const& instance) : shape{instance}, leaf{i.shape}, distance{i.distance}, u_(i.u_), v_(i.v_) {}
+
 float Intersection::get_distance() const {
     return distance;
 }
@@ -12,6 +15,10 @@ ShapeConstPtr Intersection::get_shape() const {
     return shape;
 }
 
+ShapeConstPtr Intersection::get_leaf() const {
+    return leaf;
+}
+
 float Intersection::u() const {
     return u_;
 }
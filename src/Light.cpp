@@ -19,6 +19,59 @@ size_t Light::n_samples() const {
     return n_samples_;
 }
 
+Tuple Light::sample_point(size_t i) const {
+    return sample_cache_[i];
+}
+
+bool Light::shade_per_sample() const {
+    return true;
+}
+
+Bounds Light::bounds() const {
+    return Bounds(position_, position_);
+}
+
+float Light::range() const {
+    return INF;
+}
+
+float Light::attenuation(const Tuple &p) const {
+    return 1.0f;
+}
+
+// The diffuse and specular light from a single sample on the light
+static Color sample_lighting(const Material &m, const Color &effective_color, const LightPtr &light, const Tuple &sample, const Tuple &p, const Tuple &eyev, const Tuple &normalv) {
+    Color diffuse, specular;
+    // Find the direction to the light source
+    Tuple lightv = (sample - p).normalize();
+
+    // light_dot_normal represents the cosine of the angle between the # light vector
+    // and the normal vector. A negative number means the # light is on the other
+    // side of the surface.
+    const float light_dot_normal = lightv.dot(normalv);
+
+    if (light_dot_normal < 0.0f) {
+        diffuse = Color::black();
+        specular = Color::black();
+    } else {
+        // Compute the diffuse contribution
+        diffuse = (effective_color * m.get_diffuse() * light_dot_normal);
+
+        // Reflect_dot_eye represents the cosine of the angle between the reflection vector and the eye vector. A negative number means the # light reflects away from the eye.
+        const Tuple reflectv = (-lightv).reflect(normalv);
+        const float reflect_dot_eye = reflectv.dot(eyev);
+
+        if (reflect_dot_eye <= 0.0f)
+            specular = Color::black();
+        else {
+            // Compute the specular contribution
+            const float factor = powf(reflect_dot_eye, m.get_shininess());
+            specular = light->intensity() * m.get_specular() * factor;
+        }
+    }
+    return diffuse + specular;
+}
+
 Color Lighting(const Material &m, const ShapeConstPtr &s, const LightPtr &light, const Tuple &p, const Tuple &eyev, const Tuple &normalv, float light_intensity) {
     // Combine the surface color with the light's color/intensity
     Color effective_color = m.color_at(s, p) * light->intensity();
@@ -26,44 +79,39 @@ Color Lighting(const Material &m, const ShapeConstPtr &s, const LightPtr &light,
     // Compute the ambient contribution
     Color ambient = effective_color * m.get_ambient();
 
+    const float attenuation = light->attenuation(p);
     if (equal(light_intensity, 0.0f))
-        return ambient;
+        return ambient * attenuation;
 
 
     Color sum = Color::black();
     for (auto sample : light->sample_cache_) {
-        Color diffuse, specular;
-        // Find the direction to the light source
-        Tuple lightv = (sample - p).normalize();
+        sum = sum + sample_lighting(m, effective_color, light, sample, p, eyev, normalv);
+    }
+    return (ambient + (sum / light->n_samples()) * light_intensity) * attenuation;
+}
 
-        // light_dot_normal represents the cosine of the angle between the # light vector
-        // and the normal vector. A negative number means the # light is on the other
-        // side of the surface.
-        const float light_dot_normal = lightv.dot(normalv);
+// Shading and shadows in one pass over the samples of the light. Samples behind the surface are skipped,
+// every other sample casts one shadow ray and only adds as much of its own light as gets through.
+Color Lighting(const Material &m, const ShapeConstPtr &s, const LightPtr &light, const Tuple &p, const Tuple &eyev, const Tuple &normalv, const World &w) {
+    // Out of reach of the light, no shadow rays needed
+    const float attenuation = light->attenuation(p);
+    if (attenuation == 0.0f)
+        return Color::black();
 
-        if (light_dot_normal < 0.0f) {
-            diffuse = Color::black();
-            specular = Color::black();
-        } else {
-            // Compute the diffuse contribution
-            diffuse = (effective_color * m.get_diffuse() * light_dot_normal);
-
-            // Reflect_dot_eye represents the cosine of the angle between the reflection vector and the eye vector. A negative number means the # light reflects away from the eye.
-            const Tuple reflectv = (-lightv).reflect(normalv);
-            const float reflect_dot_eye = reflectv.dot(eyev);
-
-            if (reflect_dot_eye <= 0.0f)
-                specular = Color::black();
-            else {
-                // Compute the specular contribution
-                const float factor = powf(reflect_dot_eye, m.get_shininess());
-                specular = light->intensity() * m.get_specular() * factor;
-            }
-        }
-        sum = sum + diffuse;
-        sum = sum + specular;
+    const Color effective_color = m.color_at(s, p) * light->intensity();
+    const Color ambient = effective_color * m.get_ambient();
+
+    Color sum = Color::black();
+    for (size_t i = 0; i < light->n_samples(); i++) {
+        const Tuple sample = light->sample_point(i);
+        if ((sample - p).dot(normalv) < 0.0f)
+            continue;
+        const float visible = w.visibility(p, sample, light.get());
+        if (visible > 0.0f)
+            sum = sum + sample_lighting(m, effective_color, light, sample, p, eyev, normalv) * visible;
     }
-    return ambient + (sum / light->n_samples()) * light_intensity;
+    return (ambient + sum / light->n_samples()) * attenuation;
 }
 
 bool Light::is_equal(const Light &rhs) const {
@@ -0,0 +1,78 @@
+#include "LightGrid.hpp"
+#include "Light.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// The box around the sphere of influence of a light
+static Bounds influence(const Light &light) {
+    const Bounds b = light.bounds();
+    const float r = light.range();
+    return Bounds(b.min() - Vector(r, r, r), b.max() + Vector(r, r, r));
+}
+
+// Cells are about as large as the average sphere of influence, so a light overlaps only a few of them
+LightGrid::LightGrid(const std::vector<LightPtr> &lights) {
+    std::vector<LightPtr> bounded;
+    float diameter = 0.0f;
+    for (const auto &light : lights) {
+        if (light->range() == INF) {
+            unbounded_.push_back(light);
+        } else {
+            bounded.push_back(light);
+            bounds_.merge(influence(*light));
+            diameter += 2.0f * light->range();
+        }
+    }
+    if (bounded.empty()) {
+        std::fill(dims_, dims_ + 3, 0);
+        return;
+    }
+    diameter /= bounded.size();
+
+    const Tuple extent = bounds_.max() - bounds_.min();
+    for (int i = 0; i < 3; i++) {
+        // Lights with a radius of 0 reach nothing, a single cell is enough for them. The count is clamped
+        // before the cast, which is undefined for values out of the range of an int.
+        const float n = diameter > 0.0f ? std::ceil(extent[i] / diameter) : 1.0f;
+        dims_[i] = n < LIGHT_GRID_MAX_CELLS ? std::max((int) n, 1) : LIGHT_GRID_MAX_CELLS;
+        cell_size_[i] = extent[i] / dims_[i];
+    }
+    cells_.resize(dims_[0] * dims_[1] * dims_[2]);
+
+    auto cell_of = [&](float x, int i) {
+        return cell_size_[i] > 0.0f ? std::clamp((int) ((x - bounds_.min()[i]) / cell_size_[i]), 0, dims_[i] - 1) : 0;
+    };
+    for (const auto &light : bounded) {
+        const Bounds b = influence(*light);
+        int lo[3], hi[3];
+        for (int i = 0; i < 3; i++) {
+            lo[i] = cell_of(b.min()[i], i);
+            hi[i] = cell_of(b.max()[i], i);
+        }
+        for (int z = lo[2]; z <= hi[2]; z++)
+            for (int y = lo[1]; y <= hi[1]; y++)
+                for (int x = lo[0]; x <= hi[0]; x++)
+                    cells_[(z * dims_[1] + y) * dims_[0] + x].push_back(light);
+    }
+}
+
+const std::vector<LightPtr>& LightGrid::lights_at(const Tuple &p) const {
+    if (cells_.empty())
+        return empty_;
+    int c[3];
+    for (int i = 0; i < 3; i++) {
+        if (p[i] < bounds_.min()[i] || p[i] > bounds_.max()[i])
+            return empty_;
+        c[i] = cell_size_[i] > 0.0f ? std::min((int) ((p[i] - bounds_.min()[i]) / cell_size_[i]), dims_[i] - 1) : 0;
+    }
+    return cells_[(c[2] * dims_[1] + c[1]) * dims_[0] + c[0]];
+}
+
+const std::vector<LightPtr>& LightGrid::unbounded() const {
+    return unbounded_;
+}
+
+int LightGrid::n_cells() const {
+    return (int) cells_.size();
+}
@@ -0,0 +1,133 @@
+#include "LightTree.hpp"
+#include "Light.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+// The brightness of a light, the mean of its channels
+static float power_of(const Light &light) {
+    const Color c = light.intensity();
+    return (c.red() + c.green() + c.blue()) / 3.0f;
+}
+
+LightTree::LightTree(const std::vector<LightPtr> &lights) :
+    lights_(lights)
+{
+    if (lights_.empty())
+        return;
+    std::vector<int> indices(lights_.size());
+    std::iota(indices.begin(), indices.end(), 0);
+    nodes_.reserve(2 * lights_.size() - 1);
+    build(indices, 0, indices.size());
+}
+
+// Splits at the median of the light positions along the longest axis of their bounds
+int LightTree::build(std::vector<int> &indices, size_t begin, size_t end) {
+    const int index = (int) nodes_.size();
+    nodes_.push_back(Node());
+    if (end - begin == 1) {
+        const Light &light = *lights_[indices[begin]];
+        nodes_[index] = {light.bounds(), power_of(light), light.range(), -1, -1, indices[begin]};
+        return index;
+    }
+
+    Bounds centroids;
+    for (size_t i = begin; i < end; i++)
+        centroids.update(lights_[indices[i]]->position());
+    const Tuple extent = centroids.max() - centroids.min();
+    const int axis = extent[0] > extent[1] ? (extent[0] > extent[2] ? 0 : 2) : (extent[1] > extent[2] ? 1 : 2);
+    const size_t mid = (begin + end) / 2;
+    std::nth_element(indices.begin() + begin, indices.begin() + mid, indices.begin() + end, [&](int a, int b) {
+        return lights_[a]->position()[axis] < lights_[b]->position()[axis];
+    });
+
+    const int left = build(indices, begin, mid);
+    const int right = build(indices, mid, end);
+    Node &node = nodes_[index];
+    node.bounds = nodes_[left].bounds;
+    node.bounds.merge(nodes_[right].bounds);
+    node.power = nodes_[left].power + nodes_[right].power;
+    node.range = std::max(nodes_[left].range, nodes_[right].range);
+    node.left = left;
+    node.right = right;
+    node.light = -1;
+    return index;
+}
+
+// Zero when the lights are all out of range or all behind the surface, the total power otherwise
+float LightTree::bound(const Node &node, const Tuple &p, const Tuple &n) const {
+    const Tuple lo = node.bounds.min(), hi = node.bounds.max();
+    float d2 = 0.0f, facing = 0.0f;
+    for (int i = 0; i < 3; i++) {
+        const float d = std::max({lo[i] - p[i], 0.0f, p[i] - hi[i]});
+        d2 += d * d;
+        facing += std::max((lo[i] - p[i]) * n[i], (hi[i] - p[i]) * n[i]);
+    }
+    if (facing < 0.0f || d2 > node.range * node.range)
+        return 0.0f;
+    return node.power;
+}
+
+// Power over the squared distance to the centre of the node, but not closer than the size of the node
+float LightTree::importance(const Node &node, const Tuple &p, const Tuple &n) const {
+    const float power = bound(node, p, n);
+    if (power == 0.0f)
+        return 0.0f;
+    const Tuple centre = (node.bounds.min() + node.bounds.max()) * 0.5f;
+    const Tuple half = (node.bounds.max() - node.bounds.min()) * 0.5f;
+    const Tuple d = centre - p;
+    const float d2 = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+    const float r2 = half[0] * half[0] + half[1] * half[1] + half[2] * half[2];
+    return power / std::max({d2, r2, EPSILON});
+}
+
+void LightTree::cull(const Tuple &p, const Tuple &n, float threshold, std::vector<LightPtr> &out) const {
+    if (!nodes_.empty())
+        cull(0, p, n, threshold, out);
+}
+
+void LightTree::cull(int index, const Tuple &p, const Tuple &n, float threshold, std::vector<LightPtr> &out) const {
+    const Node &node = nodes_[index];
+    const float b = bound(node, p, n);
+    if (b == 0.0f || b < threshold)
+        return;
+    if (node.light >= 0) {
+        out.push_back(lights_[node.light]);
+        return;
+    }
+    cull(node.left, p, n, threshold, out);
+    cull(node.right, p, n, threshold, out);
+}
+
+LightPtr LightTree::sample(const Tuple &p, const Tuple &n, float u, float *pdf) const {
+    *pdf = 0.0f;
+    if (nodes_.empty() || importance(nodes_[0], p, n) == 0.0f)
+        return nullptr;
+    float prob = 1.0f;
+    int index = 0;
+    while (nodes_[index].light < 0) {
+        const Node &node = nodes_[index];
+        const float il = importance(nodes_[node.left], p, n);
+        const float ir = importance(nodes_[node.right], p, n);
+        if (il + ir == 0.0f)
+            return nullptr;
+        const float p_left = il / (il + ir);
+        // Reuse u for the next level
+        if (u < p_left) {
+            u = u / p_left;
+            prob *= p_left;
+            index = node.left;
+        } else {
+            u = (u - p_left) / (1.0f - p_left);
+            prob *= 1.0f - p_left;
+            index = node.right;
+        }
+        u = std::min(u, 1.0f - EPSILON);
+    }
+    *pdf = prob;
+    return lights_[nodes_[index].light];
+}
+
+size_t LightTree::n_nodes() const {
+    return nodes_.size();
+}
@@ -1,5 +1,6 @@
 #include "Material.hpp"
 #include "Pattern.hpp"
+#include "PatternProgram.hpp"
 
 Material::Material() :
     pattern(std::make_shared<PatternSolid>(Color(1.0f, 1.0f, 1.0f))),
@@ -10,7 +11,8 @@ Material::Material() :
     reflective(0.0f),
     transparency(0.0f),
     refractive_index(1.0f),
-    shadow(true)
+    shadow(true),
+    absorption(0.0f)
 {}
 
 Material::Material(Color color, float ambient, float diffuse, float specular, float shininess, float reflective, float transparency, float refractive_index, bool shadow)
@@ -22,13 +24,21 @@ Material::Material(Color color, float ambient, float diffuse, float specular, fl
       reflective(reflective),
       transparency(transparency),
       refractive_index(refractive_index),
-      shadow(shadow)
+      shadow(shadow),
+      absorption(0.0f)
 {}
 
 Color Material::color_at(const ShapeConstPtr &s, const Tuple &p) const {
     return pattern->shape_color_at(s, p);
 }
 
+void Material::compile_pattern() {
+    // Nothing to gain for a single pattern
+    if (!std::dynamic_pointer_cast<PatternBinary>(pattern))
+        return;
+    pattern = std::make_shared<PatternProgram>(pattern);
+}
+
 const Color& Material::get_color() const {
     static const Color c = pattern->color_at(Point(0.0f, 0.0f, 0.0f), nullptr);
     return c;
@@ -58,6 +68,10 @@ float Material::get_refractive_index() const {
     return refractive_index;
 }
 
+float Material::get_absorption() const {
+    return absorption;
+}
+
 float Material::get_ambient() const {
     return ambient;
 }
@@ -101,6 +115,10 @@ void Material::set_refractive_index(float n_refractive_index) {
     refractive_index = n_refractive_index;
 }
 
+void Material::set_absorption(float n_absorption) {
+    absorption = n_absorption;
+}
+
 bool operator==(const Material &lhs, const Material &rhs) {
     if (&lhs == &rhs)
         return true;
@@ -111,7 +129,8 @@ bool operator==(const Material &lhs, const Material &rhs) {
            equal(lhs.shininess, rhs.shininess) &&
            equal(lhs.reflective, rhs.reflective) &&
            equal(lhs.transparency, rhs.transparency) &&
-           equal(lhs.refractive_index, rhs.refractive_index);
+           equal(lhs.refractive_index, rhs.refractive_index) &&
+           equal(lhs.absorption, rhs.absorption);
 }
 
 bool operator!=(const Material& lhs, const Material& rhs) {
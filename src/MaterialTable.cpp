@@ -0,0 +1,87 @@
+#include "MaterialTable.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+static constexpr uint32_t default_id = 0;
+
+// The default material is in place before any shape can refer to it
+MaterialTable::Table::Table() : end(default_id + 1) {
+    std::fill(chunks, chunks + MATERIAL_MAX_CHUNKS, nullptr);
+    chunks[0] = new Entry[MATERIAL_CHUNK_SIZE]();
+}
+
+MaterialTable::Table::~Table() {
+    for (Entry *chunk : chunks)
+        delete[] chunk;
+}
+
+uint32_t MaterialTable::add(const Material &m) {
+    Table &t = table();
+    std::lock_guard<std::mutex> lock(t.mutex);
+    uint32_t id;
+    if (!t.free_ids.empty()) {
+        id = t.free_ids.back();
+        t.free_ids.pop_back();
+    } else {
+        id = t.end;
+        const uint32_t chunk = id / MATERIAL_CHUNK_SIZE;
+        if (chunk >= MATERIAL_MAX_CHUNKS)
+            throw std::length_error("The material table is full!");
+        if (!t.chunks[chunk])
+            t.chunks[chunk] = new Entry[MATERIAL_CHUNK_SIZE]();
+        t.end = id + 1;
+    }
+    Entry &e = entry(id);
+    e.material = m;
+    e.references.store(1, std::memory_order_release);
+    return id;
+}
+
+Material& MaterialTable::mod(uint32_t id) {
+    assert(id != default_id);
+    return entry(id).material;
+}
+
+// The default material is left alone, so shapes built or destroyed while other files are initialized or
+// torn down don't depend on the table
+void MaterialTable::acquire(uint32_t id) {
+    if (id == default_id)
+        return;
+    entry(id).references.fetch_add(1, std::memory_order_relaxed);
+}
+
+void MaterialTable::release(uint32_t id) {
+    if (id == default_id)
+        return;
+    Entry &e = entry(id);
+    assert(e.references.load(std::memory_order_relaxed) > 0);
+    if (e.references.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        return;
+    // Drops the pattern of the material before the id is reused
+    e.material = Material();
+    Table &t = table();
+    std::lock_guard<std::mutex> lock(t.mutex);
+    t.free_ids.push_back(id);
+}
+
+bool MaterialTable::is_shared(uint32_t id) {
+    return id == default_id || entry(id).references.load(std::memory_order_acquire) > 1;
+}
+
+uint32_t MaterialTable::size() {
+    Table &t = table();
+    std::lock_guard<std::mutex> lock(t.mutex);
+    return t.end - static_cast<uint32_t>(t.free_ids.size());
+}
+
+void MaterialTable::compile_patterns() {
+    Table &t = table();
+    std::lock_guard<std::mutex> lock(t.mutex);
+    for (uint32_t id = default_id + 1; id < t.end; id++) {
+        Entry &e = entry(id);
+        if (e.references.load(std::memory_order_acquire) > 0)
+            e.material.compile_pattern();
+    }
+}
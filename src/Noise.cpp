@@ -0,0 +1,184 @@
+#include "Noise.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// The permutation of the reference implementation
+static const uint8_t permutation[256] = {
+    151, 160, 137, 91, 90, 15, 131, 13, 201, 95, 96, 53, 194, 233, 7, 225,
+    140, 36, 103, 30, 69, 142, 8, 99, 37, 240, 21, 10, 23, 190, 6, 148,
+    247, 120, 234, 75, 0, 26, 197, 62, 94, 252, 219, 203, 117, 35, 11, 32,
+    57, 177, 33, 88, 237, 149, 56, 87, 174, 20, 125, 136, 171, 168, 68, 175,
+    74, 165, 71, 134, 139, 48, 27, 166, 77, 146, 158, 231, 83, 111, 229, 122,
+    60, 211, 133, 230, 220, 105, 92, 41, 55, 46, 245, 40, 244, 102, 143, 54,
+    65, 25, 63, 161, 1, 216, 80, 73, 209, 76, 132, 187, 208, 89, 18, 169,
+    200, 196, 135, 130, 116, 188, 159, 86, 164, 100, 109, 198, 173, 186, 3, 64,
+    52, 217, 226, 250, 124, 123, 5, 202, 38, 147, 118, 126, 255, 82, 85, 212,
+    207, 206, 59, 227, 47, 16, 58, 17, 182, 189, 28, 42, 223, 183, 170, 213,
+    119, 248, 152, 2, 44, 154, 163, 70, 221, 153, 101, 155, 167, 43, 172, 9,
+    129, 22, 39, 253, 19, 98, 108, 110, 79, 113, 224, 232, 178, 185, 112, 104,
+    218, 246, 97, 228, 251, 34, 242, 193, 238, 210, 144, 12, 191, 179, 162, 241,
+    81, 51, 145, 235, 249, 14, 239, 107, 49, 192, 214, 31, 181, 199, 106, 157,
+    184, 84, 204, 176, 115, 121, 50, 45, 127, 4, 150, 254, 138, 236, 205, 93,
+    222, 114, 67, 29, 24, 72, 243, 141, 128, 195, 78, 66, 215, 61, 156, 180
+};
+
+// Repeated once, hashing a corner adds up to 2 cell coordinates to an entry and needs no wrapping
+static const std::array<uint8_t, 512> perm = [] {
+    std::array<uint8_t, 512> perm;
+    for (int i = 0; i < 512; i++)
+        perm[i] = permutation[i & 255];
+    return perm;
+}();
+
+// The 12 directions to the edges of a cube, padded to 16 so that a hash picks one with a mask
+static const float grad_x[16] = {1, -1, 1, -1, 1, -1, 1, -1, 0, 0, 0, 0, 1, 0, -1, 0};
+static const float grad_y[16] = {1, 1, -1, -1, 0, 0, 0, 0, 1, -1, 1, -1, 1, -1, 1, -1};
+static const float grad_z[16] = {0, 0, 0, 0, 1, 1, -1, -1, 1, 1, -1, -1, 0, 1, 0, -1};
+
+// Hashes of the 8 corners of a cell, corner c is offset by (c & 1, (c >> 1) & 1, c >> 2)
+static inline void corner_hashes(int x, int y, int z, uint8_t *h) {
+    const int a = perm[x] + y, aa = perm[a] + z, ab = perm[a + 1] + z;
+    const int b = perm[x + 1] + y, ba = perm[b] + z, bb = perm[b + 1] + z;
+    h[0] = perm[aa];
+    h[1] = perm[ba];
+    h[2] = perm[ab];
+    h[3] = perm[bb];
+    h[4] = perm[aa + 1];
+    h[5] = perm[ba + 1];
+    h[6] = perm[ab + 1];
+    h[7] = perm[bb + 1];
+}
+
+static inline float fade(float t) {
+    return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+}
+
+static inline float lerp(float t, float a, float b) {
+    return a + t * (b - a);
+}
+
+static float noise(float x, float y, float z) {
+    const float fx = std::floor(x), fy = std::floor(y), fz = std::floor(z);
+    uint8_t h[8];
+    corner_hashes((int) fx & 255, (int) fy & 255, (int) fz & 255, h);
+    x -= fx;
+    y -= fy;
+    z -= fz;
+    float d[8];
+    for (int c = 0; c < 8; c++) {
+        const int g = h[c] & 15;
+        d[c] = grad_x[g] * (x - (c & 1)) + grad_y[g] * (y - ((c >> 1) & 1)) + grad_z[g] * (z - (c >> 2));
+    }
+    const float u = fade(x), v = fade(y), w = fade(z);
+    return lerp(w, lerp(v, lerp(u, d[0], d[1]), lerp(u, d[2], d[3])),
+                   lerp(v, lerp(u, d[4], d[5]), lerp(u, d[6], d[7])));
+}
+
+float perlin_noise(const Tuple &p) {
+    return noise(p.get_x(), p.get_y(), p.get_z());
+}
+
+#if defined(__SSE2__)
+// SSE2 has no rounding instruction, truncate and correct the negative values
+static inline __m128 floor4(__m128 x) {
+    const __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+    return _mm_sub_ps(t, _mm_and_ps(_mm_cmplt_ps(x, t), _mm_set1_ps(1.0f)));
+}
+
+static inline __m128 fade4(__m128 t) {
+    const __m128 s = _mm_add_ps(_mm_mul_ps(t, _mm_sub_ps(_mm_mul_ps(t, _mm_set1_ps(6.0f)), _mm_set1_ps(15.0f))),
+                                _mm_set1_ps(10.0f));
+    return _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(t, t), t), s);
+}
+
+static inline __m128 lerp4(__m128 t, __m128 a, __m128 b) {
+    return _mm_add_ps(a, _mm_mul_ps(t, _mm_sub_ps(b, a)));
+}
+
+// The hashing has no SSE2 equivalent of the table lookups and is done per point, the gradients, their dot
+// products and the interpolation are done for all 4 points at once
+void perlin_noise4(const float *x, const float *y, const float *z, float *out) {
+    const __m128 px = _mm_loadu_ps(x), py = _mm_loadu_ps(y), pz = _mm_loadu_ps(z);
+    const __m128 fx = floor4(px), fy = floor4(py), fz = floor4(pz);
+    const __m128i mask = _mm_set1_epi32(255);
+    alignas(16) int32_t ix[4], iy[4], iz[4];
+    _mm_store_si128((__m128i*) ix, _mm_and_si128(_mm_cvttps_epi32(fx), mask));
+    _mm_store_si128((__m128i*) iy, _mm_and_si128(_mm_cvttps_epi32(fy), mask));
+    _mm_store_si128((__m128i*) iz, _mm_and_si128(_mm_cvttps_epi32(fz), mask));
+
+    alignas(16) float gx[8][4], gy[8][4], gz[8][4];
+    for (int l = 0; l < 4; l++) {
+        uint8_t h[8];
+        corner_hashes(ix[l], iy[l], iz[l], h);
+        for (int c = 0; c < 8; c++) {
+            const int g = h[c] & 15;
+            gx[c][l] = grad_x[g];
+            gy[c][l] = grad_y[g];
+            gz[c][l] = grad_z[g];
+        }
+    }
+
+    const __m128 rx = _mm_sub_ps(px, fx), ry = _mm_sub_ps(py, fy), rz = _mm_sub_ps(pz, fz);
+    const __m128 one = _mm_set1_ps(1.0f);
+    __m128 d[8];
+    for (int c = 0; c < 8; c++) {
+        const __m128 ox = c & 1 ? _mm_sub_ps(rx, one) : rx;
+        const __m128 oy = (c >> 1) & 1 ? _mm_sub_ps(ry, one) : ry;
+        const __m128 oz = c >> 2 ? _mm_sub_ps(rz, one) : rz;
+        d[c] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_load_ps(gx[c]), ox), _mm_mul_ps(_mm_load_ps(gy[c]), oy)),
+                          _mm_mul_ps(_mm_load_ps(gz[c]), oz));
+    }
+    const __m128 u = fade4(rx), v = fade4(ry), w = fade4(rz);
+    _mm_storeu_ps(out, lerp4(w, lerp4(v, lerp4(u, d[0], d[1]), lerp4(u, d[2], d[3])),
+                                lerp4(v, lerp4(u, d[4], d[5]), lerp4(u, d[6], d[7]))));
+}
+#else
+void perlin_noise4(const float *x, const float *y, const float *z, float *out) {
+    for (int i = 0; i < 4; i++)
+        out[i] = noise(x[i], y[i], z[i]);
+}
+#endif
+
+template <bool ABS>
+static float octaves_sum(const Tuple &p, int octaves, float lacunarity, float gain) {
+    octaves = std::clamp(octaves, 0, NOISE_MAX_OCTAVES);
+    alignas(16) float x[NOISE_MAX_OCTAVES], y[NOISE_MAX_OCTAVES], z[NOISE_MAX_OCTAVES];
+    alignas(16) float amplitude[NOISE_MAX_OCTAVES], n[NOISE_MAX_OCTAVES];
+    float frequency = 1.0f, a = 1.0f;
+    for (int i = 0; i < octaves; i++) {
+        x[i] = p.get_x() * frequency;
+        y[i] = p.get_y() * frequency;
+        z[i] = p.get_z() * frequency;
+        amplitude[i] = a;
+        frequency *= lacunarity;
+        a *= gain;
+    }
+    // Pad to a multiple of 4 with octaves that do not count
+    const int padded = (octaves + 3) & ~3;
+    for (int i = octaves; i < padded; i++) {
+        x[i] = y[i] = z[i] = 0.0f;
+        amplitude[i] = 0.0f;
+    }
+    float sum = 0.0f;
+    for (int i = 0; i < padded; i += 4) {
+        perlin_noise4(x + i, y + i, z + i, n + i);
+        for (int j = i; j < i + 4; j++)
+            sum += amplitude[j] * (ABS ? std::fabs(n[j]) : n[j]);
+    }
+    return sum;
+}
+
+float fbm(const Tuple &p, int octaves, float lacunarity, float gain) {
+    return octaves_sum<false>(p, octaves, lacunarity, gain);
+}
+
+float turbulence(const Tuple &p, int octaves, float lacunarity, float gain) {
+    return octaves_sum<true>(p, octaves, lacunarity, gain);
+}
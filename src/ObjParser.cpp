@@ -204,7 +204,8 @@ const std::string ObjGroup::name() const {
 std::shared_ptr<Group> ObjGroup::to_group() const {
     std::shared_ptr<Group> g = std::make_shared<Group>();
     for (auto face : faces_)
-        g->add_child(face);
+        g->add_child(face, false);
+    g->update_bounds();
     return g;
 }
 
@@ -357,6 +358,12 @@ std::shared_ptr<Group> ObjParser::obj_to_group() const {
     return top_group;
 }
 
+std::shared_ptr<Group> ObjParser::obj_to_group(const BVHOptions &options) const {
+    std::shared_ptr<Group> top_group = obj_to_group();
+    top_group->divide(options);
+    return top_group;
+}
+
 bool ObjParser::load_obj(std::istream *is) {
     groups_.push_back(new ObjGroup(""));
     n_line_ = 0;
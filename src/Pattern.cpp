@@ -1,5 +1,6 @@
 #include "Pattern.hpp"
 #include "Shape.hpp"
+#include "Noise.hpp"
 
 Pattern::Pattern() :
     transform(Matrix<4, 4>::identity()),
@@ -93,6 +94,27 @@ Color PatternBlend::color_at(const Tuple &p, const ShapeConstPtr &s) const {
     return (color_a(p, s) + color_b(p, s)) * 0.5f;
 }
 
+Color PatternFbm::color_at(const Tuple &p, const ShapeConstPtr &s) const {
+    const float fraction = std::clamp(0.5f + 0.5f * fbm(p, octaves_), 0.0f, 1.0f);
+    return color_a(p, s) + (color_b(p, s) - color_a(p, s)) * fraction;
+}
+
+Color PatternTurbulence::color_at(const Tuple &p, const ShapeConstPtr &s) const {
+    const float fraction = std::min(turbulence(p, octaves_), 1.0f);
+    return color_a(p, s) + (color_b(p, s) - color_a(p, s)) * fraction;
+}
+
+Color PatternMarble::color_at(const Tuple &p, const ShapeConstPtr &s) const {
+    const float fraction = 0.5f + 0.5f * std::sin((p.get_x() + distortion_ * turbulence(p, octaves_)) * (float) M_PI);
+    return color_a(p, s) + (color_b(p, s) - color_a(p, s)) * fraction;
+}
+
+Color PatternWood::color_at(const Tuple &p, const ShapeConstPtr &s) const {
+    const float r = std::sqrt(p.get_x() * p.get_x() + p.get_z() * p.get_z()) + distortion_ * fbm(p, octaves_);
+    const float fraction = r - std::floor(r);
+    return color_a(p, s) + (color_b(p, s) - color_a(p, s)) * fraction;
+}
+
 
 Color PatternUvCheckers::color_at(const Tuple &p, const ShapeConstPtr &s) const {
     // TODO: Find something nicer
@@ -0,0 +1,196 @@
+#include "PatternProgram.hpp"
+
+#include <typeinfo>
+
+PatternProgram::PatternProgram(const PatternConstPtr &root) {
+    // The transform of the root is applied before color_at(), like for the pattern itself
+    set_transform(root->get_transform());
+    compile(root, Matrix<4, 4>::identity(), true);
+}
+
+static PatternOp binary_op(const Pattern &p) {
+    const std::type_info &type = typeid(p);
+    if (type == typeid(PatternStripe))
+        return PatternOp::Stripe;
+    if (type == typeid(PatternGradient))
+        return PatternOp::Gradient;
+    if (type == typeid(PatternRing))
+        return PatternOp::Ring;
+    if (type == typeid(PatternCheckers))
+        return PatternOp::Checkers;
+    if (type == typeid(PatternRadialGradient))
+        return PatternOp::RadialGradient;
+    if (type == typeid(PatternBlend))
+        return PatternOp::Blend;
+    return PatternOp::Call;
+}
+
+uint32_t PatternProgram::compile(const PatternConstPtr &p, const Matrix<4, 4> &parent_inv, bool root) {
+    const uint32_t i = (uint32_t) nodes_.size();
+    const bool reuse = root || p->get_transform_inv() == Matrix<4, 4>::identity();
+    const Matrix<4, 4> inv = root ? parent_inv : p->get_transform_inv() * parent_inv;
+    nodes_.push_back({PatternOp::Call, reuse, 0, 0, Color::black(), inv, p.get()});
+
+    // Subclasses may override color_at(), only the exact types are compiled
+    if (typeid(*p) == typeid(PatternSolid)) {
+        nodes_[i].op = PatternOp::Solid;
+        nodes_[i].color = static_cast<const PatternSolid&>(*p).get_color();
+        return i;
+    }
+    const PatternOp op = binary_op(*p);
+    if (op == PatternOp::Call) {
+        calls_.push_back(p);
+        return i;
+    }
+
+    const PatternBinary &binary = static_cast<const PatternBinary&>(*p);
+    const uint32_t a = compile(binary.get_pattern_a(), inv, false);
+    const uint32_t b = compile(binary.get_pattern_b(), inv, false);
+    nodes_[i].op = op;
+    nodes_[i].a = a;
+    nodes_[i].b = b;
+
+    // Two solid children of the same color, or blended, fold into a single solid
+    if (nodes_[a].op == PatternOp::Solid && nodes_[b].op == PatternOp::Solid &&
+        (op == PatternOp::Blend || nodes_[a].color == nodes_[b].color)) {
+        nodes_[i].op = PatternOp::Solid;
+        nodes_[i].color = op == PatternOp::Blend ? (nodes_[a].color + nodes_[b].color) * 0.5f : nodes_[a].color;
+        nodes_.resize(i + 1);
+    }
+    return i;
+}
+
+size_t PatternProgram::n_nodes() const {
+    return nodes_.size();
+}
+
+inline Tuple PatternProgram::local(uint32_t i, const Tuple &p0, const Tuple &p) const {
+    return nodes_[i].reuse ? p : nodes_[i].inv * p0;
+}
+
+// Whether the point picks the second child of a selecting node, the same tests as in Pattern.cpp
+static inline bool picks_b(PatternOp op, const Tuple &p) {
+    switch (op) {
+        case PatternOp::Stripe:
+            return (int) std::floor(p.get_x()) % 2;
+        case PatternOp::Ring:
+            return ((int) std::floor(std::sqrt(p.get_x() * p.get_x() + p.get_z() * p.get_z()))) % 2 != 0;
+        default: {
+            const int x = floor(p.get_x());
+            const int y = floor(p.get_y());
+            const int z = floor(p.get_z());
+            return (x + y + z) % 2 != 0;
+        }
+    }
+}
+
+// Combines the colors of both children of a mixing node
+static inline Color mix(PatternOp op, const Tuple &p, const Color &a, const Color &b) {
+    switch (op) {
+        case PatternOp::Gradient:
+            return a + (b - a) * std::clamp(p.get_x(), 0.0f, 1.0f);
+        case PatternOp::RadialGradient:
+            return a + (b - a) * (p - Point(0, 0, 0)).magnitude();
+        default:
+            return (a + b) * 0.5f;
+    }
+}
+
+Color PatternProgram::eval(uint32_t i, const Tuple &p0, const Tuple &p, const ShapeConstPtr &s) const {
+    const Node &node = nodes_[i];
+    switch (node.op) {
+        case PatternOp::Solid:
+            return node.color;
+        case PatternOp::Call:
+            return node.call->color_at(p, s);
+        case PatternOp::Stripe:
+        case PatternOp::Ring:
+        case PatternOp::Checkers: {
+            const uint32_t c = picks_b(node.op, p) ? node.b : node.a;
+            return eval(c, p0, local(c, p0, p), s);
+        }
+        default:
+            return mix(node.op, p,
+                       eval(node.a, p0, local(node.a, p0, p), s),
+                       eval(node.b, p0, local(node.b, p0, p), s));
+    }
+}
+
+Color PatternProgram::color_at(const Tuple &p, const ShapeConstPtr &s) const {
+    return eval(0, p, p, s);
+}
+
+// The points at idx are in the space of node i at p. A selecting node splits them over its children, so every
+// node is visited once for the batch instead of once per point.
+void PatternProgram::eval(uint32_t i, const Tuple *p0, const uint32_t *idx, const Tuple *p, size_t n, Color *out,
+                          const ShapeConstPtr &s) const {
+    const Node &node = nodes_[i];
+    switch (node.op) {
+        case PatternOp::Solid:
+            std::fill(out, out + n, node.color);
+            return;
+        case PatternOp::Call:
+            for (size_t k = 0; k < n; k++)
+                out[k] = node.call->color_at(p[k], s);
+            return;
+        case PatternOp::Stripe:
+        case PatternOp::Ring:
+        case PatternOp::Checkers: {
+            std::vector<uint8_t> side(n);
+            for (size_t k = 0; k < n; k++)
+                side[k] = picks_b(node.op, p[k]);
+            for (uint8_t b = 0; b < 2; b++) {
+                const uint32_t c = b ? node.b : node.a;
+                // Leaves are written directly
+                if (nodes_[c].op == PatternOp::Solid) {
+                    for (size_t k = 0; k < n; k++)
+                        if (side[k] == b)
+                            out[k] = nodes_[c].color;
+                    continue;
+                }
+                std::vector<uint32_t> c_idx;
+                std::vector<Tuple> c_p;
+                c_idx.reserve(n);
+                c_p.reserve(n);
+                for (size_t k = 0; k < n; k++) {
+                    if (side[k] != b)
+                        continue;
+                    c_idx.push_back(idx[k]);
+                    c_p.push_back(local(c, p0[idx[k]], p[k]));
+                }
+                if (c_idx.empty())
+                    continue;
+                std::vector<Color> c_out(c_idx.size());
+                eval(c, p0, c_idx.data(), c_p.data(), c_idx.size(), c_out.data(), s);
+                for (size_t k = 0, j = 0; k < n; k++)
+                    if (side[k] == b)
+                        out[k] = c_out[j++];
+            }
+            return;
+        }
+        default: {
+            std::vector<Color> c_out[2];
+            for (uint8_t b = 0; b < 2; b++) {
+                const uint32_t c = b ? node.b : node.a;
+                std::vector<Tuple> c_p;
+                if (!nodes_[c].reuse) {
+                    c_p.resize(n);
+                    for (size_t k = 0; k < n; k++)
+                        c_p[k] = nodes_[c].inv * p0[idx[k]];
+                }
+                c_out[b].resize(n);
+                eval(c, p0, idx, nodes_[c].reuse ? p : c_p.data(), n, c_out[b].data(), s);
+            }
+            for (size_t k = 0; k < n; k++)
+                out[k] = mix(node.op, p[k], c_out[0][k], c_out[1][k]);
+            return;
+        }
+    }
+}
+
+void PatternProgram::colors_at(const Tuple *p, Color *out, size_t n, const ShapeConstPtr &s) const {
+    std::vector<uint32_t> idx(n);
+    for (uint32_t k = 0; k < n; k++)
+        idx[k] = k;
+    eval(0, p, idx.data(), p, n, out, s);
+}
@@ -1,7 +1,8 @@
 #include "PointLight.hpp"
 
 PointLight::PointLight(Tuple position, Color intensity) :
-    Light(position, intensity)
+    Light(position, intensity),
+    radius_(INF)
 {
     n_samples_ = 1;
     sample_cache_.push_back(position);
@@ -12,13 +13,31 @@ bool operator==(const PointLight &lhs, const PointLight &rhs) {
 }
 
 float PointLight::intensity_at(const Tuple &p, const World &w) const {
-    if (w.is_shadowed(p, position_))
-        return 0.0f;
-    else
-        return 1.0f;
+    return w.visibility(p, position_, this);
 }
 
 bool PointLight::operator==(const Light &rhs) const {
     const PointLight *rhs_pointlight = dynamic_cast<const PointLight*>(&rhs);
     return rhs_pointlight && Light::operator==(rhs);
 }
+
+void PointLight::set_radius(float radius) {
+    radius_ = radius;
+}
+
+float PointLight::range() const {
+    return radius_;
+}
+
+// Inverse square falloff, offset by one to stay finite near the light, windowed to reach zero at the
+// radius: https://cdn2.unrealengine.com/Resources/files/2013SiggraphPresentationsNotes-26915738.pdf
+float PointLight::attenuation(const Tuple &p) const {
+    if (radius_ == INF)
+        return 1.0f;
+    const Tuple v = p - position_;
+    const float d2 = v.dot(v);
+    const float x = d2 * d2 / (radius_ * radius_ * radius_ * radius_);
+    if (x >= 1.0f)
+        return 0.0f;
+    return (1.0f - x) * (1.0f - x) / (d2 + 1.0f);
+}
@@ -1,9 +1,11 @@
 #include "Ray.hpp"
 #include "Shape.hpp" // TODO: Fix imports
+#include "Stats.hpp"
 
 Ray::Ray(const Tuple &origin, const Tuple &direction) : origin{origin}, direction{direction} { }
 
 void Ray::intersect(const ShapePtr &shape, std::vector<Intersection>& xs) const {
+    STATS_INTERSECT_TEST(*shape);
     Ray const r = shape->get_transform_inv() * (*this);
     shape->intersect(r, xs);
 }
@@ -12,6 +14,7 @@ void Ray::intersect(const World &world, std::vector<Intersection>& xs) const {
     for (const auto &shape : world.get_objects()) {
         intersect(shape, xs);
     }
+    STATS_HITS(xs.size());
     std::sort(xs.begin(), xs.end());
 }
 
@@ -0,0 +1,191 @@
+#include "Stats.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <mutex>
+#include <new>
+#include <sstream>
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#endif
+
+std::atomic<bool> Stats::enabled_(true);
+
+// Nothing here may allocate, the counting operator new below goes through local() as well
+static StatsCounters slots[STATS_MAX_THREADS];
+static std::atomic<bool> slot_used[STATS_MAX_THREADS];
+// One more than the highest slot ever handed out
+static std::atomic<int> n_slots(0);
+static const std::type_info *types[STATS_MAX_TYPES];
+static std::atomic<int> n_types(0);
+static std::mutex types_mutex;
+
+void Stats::set_enabled(bool enabled) {
+    enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+// Holds a slot for the lifetime of a thread and frees it when the thread exits, so the threads of later thread
+// pools reuse the slots of earlier ones. The counts stay in the slot. The last slot is never handed out, it is
+// shared by the threads that run while all others are taken, and their counts are then approximate.
+namespace {
+struct SlotHandle {
+    int index;
+    SlotHandle() : index(STATS_MAX_THREADS - 1) {
+        for (int s = 0; s < STATS_MAX_THREADS - 1; s++) {
+            bool expected = false;
+            if (!slot_used[s].load(std::memory_order_relaxed) &&
+                slot_used[s].compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                index = s;
+                break;
+            }
+        }
+        int n = n_slots.load(std::memory_order_relaxed);
+        while (n <= index && !n_slots.compare_exchange_weak(n, index + 1)) {}
+    }
+    ~SlotHandle() {
+        if (index < STATS_MAX_THREADS - 1)
+            slot_used[index].store(false, std::memory_order_release);
+        // Anything counted while the thread is torn down goes to the shared slot
+        index = STATS_MAX_THREADS - 1;
+    }
+};
+}
+
+StatsCounters& Stats::local() {
+    thread_local SlotHandle handle;
+    return slots[handle.index];
+}
+
+StatsCounters Stats::collect() {
+    StatsCounters total;
+    std::memset(&total, 0, sizeof(total));
+    for (int s = 0; s < std::min(n_slots.load(), STATS_MAX_THREADS); s++) {
+        for (int k = 0; k < (int) RayKind::Count; k++)
+            total.rays[k] += slots[s].rays[k];
+        total.bounds_tests += slots[s].bounds_tests;
+        for (int t = 0; t < STATS_MAX_TYPES; t++)
+            total.intersect_tests[t] += slots[s].intersect_tests[t];
+        total.primitive_tests += slots[s].primitive_tests;
+        total.node_visits += slots[s].node_visits;
+        total.hits += slots[s].hits;
+        total.depth_sum += slots[s].depth_sum;
+        total.depth_samples += slots[s].depth_samples;
+        total.allocations += slots[s].allocations;
+        total.allocated_bytes += slots[s].allocated_bytes;
+        total.occluder_hits += slots[s].occluder_hits;
+        total.occluder_misses += slots[s].occluder_misses;
+    }
+    return total;
+}
+
+void Stats::reset() {
+    for (int s = 0; s < STATS_MAX_THREADS; s++) {
+        const uint32_t depth = slots[s].depth;
+        std::memset(&slots[s], 0, sizeof(StatsCounters));
+        slots[s].depth = depth;
+    }
+}
+
+// Types are few, a linear search over the registered ones is enough, new ones are added under a lock
+int Stats::type_slot(const std::type_info &type) {
+    const int n = n_types.load(std::memory_order_acquire);
+    for (int t = 0; t < n; t++) {
+        if (*types[t] == type)
+            return t;
+    }
+    std::lock_guard<std::mutex> lock(types_mutex);
+    const int m = n_types.load(std::memory_order_relaxed);
+    for (int t = n; t < m; t++) {
+        if (*types[t] == type)
+            return t;
+    }
+    // The last slot collects the types that do not fit anymore
+    if (m == STATS_MAX_TYPES)
+        return STATS_MAX_TYPES - 1;
+    types[m] = &type;
+    n_types.store(m + 1, std::memory_order_release);
+    return m;
+}
+
+// Demangles the name where the ABI allows it, so templates read like "WideBVH<4>". Otherwise only the length
+// prefix of names like "6Sphere" is stripped.
+std::string Stats::type_name(int slot) {
+    if (slot >= n_types.load())
+        return "";
+    const char *name = types[slot]->name();
+#if defined(__GNUG__)
+    int status = 0;
+    char *demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+    if (status == 0 && demangled) {
+        const std::string result(demangled);
+        std::free(demangled);
+        return result;
+    }
+    std::free(demangled);
+#endif
+    while (*name >= '0' && *name <= '9')
+        name++;
+    return name;
+}
+
+void Stats::print(std::ostream &os) {
+    const StatsCounters total = collect();
+    const char *ray_names[] = {"camera", "shadow", "reflection", "refraction"};
+    os << "Rays:" << std::endl;
+    for (int k = 0; k < (int) RayKind::Count; k++)
+        os << "  " << std::left << std::setw(12) << ray_names[k] << total.rays[k] << std::endl;
+    os << "Bounds tests:  " << total.bounds_tests << std::endl;
+    os << "Intersect tests:" << std::endl;
+    for (int t = 0; t < n_types.load(); t++)
+        os << "  " << std::left << std::setw(16) << type_name(t) << total.intersect_tests[t] << std::endl;
+    os << "Primitives:    " << total.primitive_tests << std::endl;
+    os << "Node visits:   " << total.node_visits << std::endl;
+    os << "Hits:          " << total.hits << std::endl;
+    os << "Mean depth:    " << (total.depth_samples ? (double) total.depth_sum / total.depth_samples : 0.0) << std::endl;
+    os << "Allocations:   " << total.allocations << " (" << total.allocated_bytes << " bytes)" << std::endl;
+    os << "Occluder cache: " << total.occluder_hits << " hits, " << total.occluder_misses << " misses" << std::endl;
+}
+
+std::string Stats::to_json() {
+    const StatsCounters total = collect();
+    const char *ray_names[] = {"camera", "shadow", "reflection", "refraction"};
+    std::ostringstream os;
+    os << "{\"rays\": {";
+    for (int k = 0; k < (int) RayKind::Count; k++)
+        os << (k ? ", " : "") << '"' << ray_names[k] << "\": " << total.rays[k];
+    os << "}, \"bounds_tests\": " << total.bounds_tests << ", \"intersect_tests\": {";
+    for (int t = 0; t < n_types.load(); t++)
+        os << (t ? ", " : "") << '"' << type_name(t) << "\": " << total.intersect_tests[t];
+    os << "}, \"primitive_tests\": " << total.primitive_tests
+       << ", \"node_visits\": " << total.node_visits
+       << ", \"hits\": " << total.hits
+       << ", \"mean_depth\": " << (total.depth_samples ? (double) total.depth_sum / total.depth_samples : 0.0)
+       << ", \"allocations\": " << total.allocations
+       << ", \"allocated_bytes\": " << total.allocated_bytes
+       << ", \"occluder_hits\": " << total.occluder_hits
+       << ", \"occluder_misses\": " << total.occluder_misses << "}";
+    return os.str();
+}
+
+#ifdef RT_STATS
+void* operator new(std::size_t size) {
+    if (Stats::enabled()) {
+        StatsCounters &local = Stats::local();
+        local.allocations++;
+        local.allocated_bytes += size;
+    }
+    void *p = std::malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+    std::free(p);
+}
+#endif
@@ -0,0 +1,95 @@
+#include "ThreadPool.hpp"
+
+ThreadPool::ThreadPool(unsigned n_threads) :
+    pending_(0),
+    queued_(0),
+    running_(true)
+{
+    for (unsigned i = 1; i < std::max(n_threads, 1u); i++)
+        workers_.emplace_back(&ThreadPool::worker, this);
+}
+
+ThreadPool::~ThreadPool() {
+    finish();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    work_cv_.notify_all();
+    for (auto &w : workers_)
+        w.join();
+}
+
+unsigned ThreadPool::size() const {
+    return (unsigned) workers_.size() + 1;
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    pending_++;
+    queue_.enqueue(std::move(task));
+    queued_++;
+    // Taking the lock orders the count before a worker that is about to sleep checks it
+    { std::lock_guard<std::mutex> lock(mutex_); }
+    work_cv_.notify_one();
+}
+
+bool ThreadPool::run_one() {
+    std::function<void()> task;
+    if (!queue_.try_dequeue(task))
+        return false;
+    queued_--;
+    try {
+        task();
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!error_)
+            error_ = std::current_exception();
+    }
+    if (pending_.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_cv_.notify_all();
+    }
+    return true;
+}
+
+void ThreadPool::worker() {
+    for (;;) {
+        if (run_one())
+            continue;
+        std::unique_lock<std::mutex> lock(mutex_);
+        work_cv_.wait(lock, [this] { return queued_ > 0 || !running_; });
+        if (!running_ && queued_ <= 0)
+            return;
+    }
+}
+
+// Helps with the queued tasks, then sleeps until the ones taken by workers are done
+void ThreadPool::finish() {
+    while (pending_ > 0) {
+        if (run_one())
+            continue;
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_cv_.wait(lock, [this] { return pending_ == 0 || queued_ > 0; });
+    }
+}
+
+void ThreadPool::wait() {
+    finish();
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::swap(error, error_);
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
+
+// Splits [0, n) into chunks of at least grain elements and blocks until f ran on all of them
+void ThreadPool::parallel_for(size_t n, size_t grain, const std::function<void(size_t, size_t)> &f) {
+    const size_t chunk = std::max(grain, (n + size() - 1) / size());
+    for (size_t begin = 0; begin < n; begin += chunk) {
+        const size_t end = std::min(n, begin + chunk);
+        submit([&f, begin, end]() { f(begin, end); });
+    }
+    wait();
+}
@@ -2,13 +2,37 @@
 #include "Ray.hpp"
 #include "Light.hpp"
 #include "World.hpp"
+#include "Stats.hpp"
+#include "LightTree.hpp"
+#include "LightGrid.hpp"
+#include "CSG.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+static uint64_t next_version() {
+    static std::atomic<uint64_t> counter(0);
+    return ++counter;
+}
 
 World::World() :
     objects(std::vector<ShapePtr>()),
-    lights(std::vector<LightPtr>())
+    lights(std::vector<LightPtr>()),
+    light_samples(0),
+    light_threshold(0.0f),
+    occluder_cache(false),
+    transparent_shadows(false),
+    version(next_version())
 {}
 
-World::World(std::initializer_list<ShapePtr> i_objects, std::initializer_list<LightPtr> i_lights) {
+World::World(std::initializer_list<ShapePtr> i_objects, std::initializer_list<LightPtr> i_lights) :
+    light_samples(0),
+    light_threshold(0.0f),
+    occluder_cache(false),
+    transparent_shadows(false),
+    version(next_version())
+{
     for (auto o : i_objects)
         objects.push_back(o);
     for (auto o : i_lights)
@@ -25,9 +49,40 @@ const std::vector<LightPtr>& World::get_lights() const {
 
 Color World::shade_hit(const IntersectionComp &comps, uint8_t remaining) const {
     Color surface = Color();
-    for (auto const &light : lights) {
-        const float light_intensity = light->intensity_at(comps.over_point, *this);
-        surface = surface + Lighting(comps.object->get_material(), comps.object, light, comps.over_point, comps.eyev, comps.normalv, light_intensity);
+    if (light_grid && !light_tree) {
+        for (auto const &light : light_grid->unbounded())
+            surface = surface + shade_light(comps, light);
+        for (auto const &light : light_grid->lights_at(comps.over_point))
+            surface = surface + shade_light(comps, light);
+    } else if (!light_tree) {
+        for (auto const &light : lights)
+            surface = surface + shade_light(comps, light);
+    } else {
+        // Lighting() adds the ambient light of every light, also of those behind the surface that the tree
+        // never picks or keeps. It needs no shadow rays, so it is added for all lights, and only the rest of
+        // the light is taken from the tree.
+        const Material &material = comps.object->get_material();
+        const Color ambient = material.color_at(comps.object, comps.over_point) * material.get_ambient();
+        auto ambient_of = [&](const LightPtr &light) {
+            return ambient * light->intensity() * light->attenuation(comps.over_point);
+        };
+        for (auto const &light : lights)
+            surface = surface + ambient_of(light);
+        if (light_samples > 0) {
+            // Dividing by the probability of the pick keeps the estimate of the sum over all lights unbiased
+            for (int i = 0; i < light_samples; i++) {
+                float pdf;
+                const LightPtr light = light_tree->sample(comps.over_point, comps.normalv, random_dbl(), &pdf);
+                if (light)
+                    surface = surface + (shade_light(comps, light) - ambient_of(light)) / (pdf * light_samples);
+            }
+        } else {
+            thread_local std::vector<LightPtr> culled;
+            culled.clear();
+            light_tree->cull(comps.over_point, comps.normalv, light_threshold, culled);
+            for (auto const &light : culled)
+                surface = surface + shade_light(comps, light) - ambient_of(light);
+        }
     }
     // TODO: How valid is this?
 //    surface = surface * (1.0f / lights.size());
@@ -36,7 +91,7 @@ Color World::shade_hit(const IntersectionComp &comps, uint8_t remaining) const {
     const Color refracted = refracted_color(comps, remaining);
 
     // Fresnel/Schlick effect
-    const Material material = comps.object->get_material();
+    const Material &material = comps.object->get_material();
     if (material.get_reflective() > 0.0f && material.get_transparency() > 0) {
         const float reflectance = Schlick(comps);
 //        const float reflectance = Fresnel(comps);
@@ -45,12 +100,23 @@ Color World::shade_hit(const IntersectionComp &comps, uint8_t remaining) const {
     return surface + reflected + refracted;
 }
 
+Color World::shade_light(const IntersectionComp &comps, const LightPtr &light) const {
+    // Skip lights that do not reach the point before casting any shadow rays
+    if (light->attenuation(comps.over_point) == 0.0f)
+        return Color::black();
+    if (light->shade_per_sample())
+        return Lighting(comps.object->get_material(), comps.object, light, comps.over_point, comps.eyev, comps.normalv, *this);
+    const float light_intensity = light->intensity_at(comps.over_point, *this);
+    return Lighting(comps.object->get_material(), comps.object, light, comps.over_point, comps.eyev, comps.normalv, light_intensity);
+}
+
 Color World::reflected_color(const IntersectionComp &comps, uint8_t remaining) const {
     const float reflective = comps.object->get_material().get_reflective();
     if (reflective == 0.0f || remaining < 1)
         return Color::black();
     
     const Ray reflect_ray = Ray(comps.over_point, comps.reflectv);
+    STATS_RAY(RayKind::Reflection);
     return color_at(reflect_ray, remaining - 1) * reflective;
 }
 
@@ -75,6 +141,7 @@ Color World::refracted_color(const IntersectionComp &comps, uint8_t remaining) c
     const Tuple direction = (comps.normalv * ((n_ratio * cos_i) - cos_t)) - (comps.eyev * n_ratio);
     // Create the refracted ray
     const Ray refract_ray = Ray(comps.under_point, direction);
+    STATS_RAY(RayKind::Refraction);
 
     return color_at(refract_ray, remaining - 1) * transparency;
 }
@@ -84,6 +151,7 @@ std::vector<LightPtr>& World::mod_lights() {
 }
 
 std::vector<ShapePtr>& World::mod_objects() {
+    version = next_version();
     return objects;
 }
 
@@ -99,6 +167,7 @@ Color World::color_at(const Ray &r, uint8_t remaining) const {
 }
 
 void World::insert(const ShapePtr &s) {
+    version = next_version();
     objects.push_back(s);
 }
 
@@ -106,15 +175,194 @@ void World::insert(const LightPtr &l) {
     lights.push_back(l);
 }
 
-bool World::is_shadowed(const Tuple &p, const Tuple &light_p) const {
+void World::build_light_tree(int n_samples, float threshold) {
+    light_tree = std::make_shared<LightTree>(lights);
+    light_samples = n_samples;
+    light_threshold = threshold;
+}
+
+void World::clear_light_tree() {
+    light_tree.reset();
+}
+
+void World::build_light_grid() {
+    light_grid = std::make_shared<LightGrid>(lights);
+}
+
+void World::clear_light_grid() {
+    light_grid.reset();
+}
+
+// A small direct mapped cache per thread, indexed by the light
+struct OccluderEntry {
+    const World *world;
+    uint64_t version;
+    const Light *light;
+    ShapeConstPtr occluder;
+    // The inverse transforms of the groups above the occluder, composed again when any transform changed
+    Matrix<4, 4> to_parent;
+    uint64_t transforms;
+};
+constexpr size_t OCCLUDER_CACHE_SIZE = 64;
+
+static OccluderEntry& occluder_entry(const Light *light) {
+    thread_local OccluderEntry entries[OCCLUDER_CACHE_SIZE];
+    return entries[(reinterpret_cast<uintptr_t>(light) >> 4) % OCCLUDER_CACHE_SIZE];
+}
+
+// The operands of a CSG do not block rays on their own, the outermost CSG around a shape is cached
+static ShapeConstPtr outermost_csg(const ShapeConstPtr &shape) {
+    ShapeConstPtr occluder = shape;
+    for (ShapeConstPtr s = shape->get_parent(); s; s = s->get_parent()) {
+        if (dynamic_cast<const CSG*>(s.get()))
+            occluder = s;
+    }
+    return occluder;
+}
+
+// The innermost group comes first, so the transform of the outermost one is applied to a ray first
+static Matrix<4, 4> to_parent_of(const ShapeConstPtr &shape) {
+    Matrix<4, 4> m = Matrix<4, 4>::identity();
+    for (ShapeConstPtr s = shape->get_parent(); s; s = s->get_parent())
+        m = m * s->get_transform_inv();
+    return m;
+}
+
+// Intersects the occluder alone, the ray goes through the transforms of the groups above it first
+bool World::blocked_by(const ShapeConstPtr &occluder, const Matrix<4, 4> &to_parent, const Ray &r, float distance) const {
+    if (!occluder->get_material().get_shadow())
+        return false;
+    thread_local std::vector<Intersection> xs;
+    xs.clear();
+    (to_parent * r).intersect(std::const_pointer_cast<Shape>(occluder), xs);
+    for (const auto &i : xs) {
+        if (i.get_distance() >= 0.0f && i.get_distance() < distance)
+            return true;
+    }
+    return false;
+}
+
+void World::set_occluder_cache(bool enabled) {
+    occluder_cache = enabled;
+}
+
+void World::set_transparent_shadows(bool enabled) {
+    transparent_shadows = enabled;
+}
+
+float World::visibility(const Tuple &p, const Tuple &light_p, const Light *light) const {
+    if (transparent_shadows)
+        return transmittance(p, light_p);
+    return is_shadowed(p, light_p, light) ? 0.0f : 1.0f;
+}
+
+// Walks the hits between p and the light in order. Opaque shapes that cast shadows block the light,
+// transparent ones let their transparency through, times exp(-absorption * thickness) for the distance
+// between entering and leaving them. A ray starting or ending inside a shape counts the part inside.
+//
+// Every triangle of a closed mesh is hit only once, so hits are not paired by shape. Instead they are paired
+// by the medium they bound, the transparency and absorption of their material: each hit enters the medium if
+// the ray is outside of it, and leaves it otherwise. This does not depend on the winding of the triangles.
+// Triangles are not hit behind the origin of a ray, so whether p is inside a medium is found from the hits in
+// front of it: the whole ray crosses a closed medium an even number of times.
+float World::transmittance(const Tuple &p, const Tuple &light_p) const {
+    const Tuple v = light_p - p;
+    const float distance = v.magnitude();
+    const Ray r = Ray(p, v.normalize());
+    STATS_RAY(RayKind::Shadow);
+
+    std::vector<Intersection> xs;
+    r.intersect(*this, xs);
+
+    // Media the ray is inside of, with the distance it entered them at
+    struct Medium {
+        float transparency;
+        float absorption;
+        float t0;
+    };
+    std::vector<Medium> inside;
+    auto find = [&inside](const Material &m) {
+        return std::find_if(inside.begin(), inside.end(), [&m](const Medium &e) {
+            return e.transparency == m.get_transparency() && e.absorption == m.get_absorption();
+        });
+    };
+    for (const auto &i : xs) {
+        if (i.get_distance() <= 0.0f)
+            continue;
+        const Material &m = i.get_shape()->get_material();
+        if (!m.get_shadow() || m.get_transparency() == 0.0f)
+            continue;
+        auto it = find(m);
+        if (it != inside.end())
+            inside.erase(it);
+        else
+            inside.push_back({m.get_transparency(), m.get_absorption(), 0.0f});
+    }
+
+    float transmittance = 1.0f;
+    auto pass = [&transmittance](const Medium &e, float t1) {
+        transmittance *= e.transparency * std::exp(-e.absorption * (t1 - e.t0));
+    };
+    for (const auto &i : xs) {
+        const float t = i.get_distance();
+        if (t <= 0.0f)
+            continue;
+        if (t >= distance)
+            break;
+        const Material &m = i.get_shape()->get_material();
+        if (!m.get_shadow())
+            continue;
+        if (m.get_transparency() == 0.0f)
+            return 0.0f;
+        auto it = find(m);
+        if (it == inside.end()) {
+            inside.push_back({m.get_transparency(), m.get_absorption(), t});
+            continue;
+        }
+        pass(*it, t);
+        inside.erase(it);
+        if (transmittance < SHADOW_MIN_TRANSMITTANCE)
+            return 0.0f;
+    }
+    // Media the light is inside of
+    for (const Medium &e : inside)
+        pass(e, distance);
+    return transmittance < SHADOW_MIN_TRANSMITTANCE ? 0.0f : transmittance;
+}
+
+bool World::is_shadowed(const Tuple &p, const Tuple &light_p, const Light *light) const {
     const Tuple v = light_p - p;
     const float distance = v.magnitude();
     const Tuple direction = v.normalize();
     const Ray r = Ray(p, direction);
+    STATS_RAY(RayKind::Shadow);
+
+    OccluderEntry *entry = nullptr;
+    if (occluder_cache && light) {
+        entry = &occluder_entry(light);
+        if (entry->world == this && entry->version == version && entry->light == light && entry->occluder) {
+            const uint64_t transforms = Shape::transform_generation();
+            if (entry->transforms != transforms) {
+                entry->to_parent = to_parent_of(entry->occluder);
+                entry->transforms = transforms;
+            }
+            if (blocked_by(entry->occluder, entry->to_parent, r, distance)) {
+                STATS_ADD(occluder_hits, 1);
+                return true;
+            }
+            STATS_ADD(occluder_misses, 1);
+        }
+    }
 
     std::vector<Intersection> xs;
     r.intersect(*this, xs);
 
     Intersection hit = Hit(xs);
-    return (hit.get_shape() != nullptr && hit.get_shape()->get_material().get_shadow() && hit.get_distance() < distance);
+    const bool shadowed = (hit.get_shape() != nullptr && hit.get_shape()->get_material().get_shadow() && hit.get_distance() < distance);
+    // A lit point keeps the occluder cached, its neighbours may still be blocked by it
+    if (entry && shadowed) {
+        const ShapeConstPtr occluder = outermost_csg(hit.get_shape());
+        *entry = {this, version, light, occluder, to_parent_of(occluder), Shape::transform_generation()};
+    }
+    return shadowed;
 }
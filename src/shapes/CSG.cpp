@@ -1,5 +1,7 @@
 #include "CSG.hpp"
 
+#include <deque>
+
 bool csgUnionOperator::intersection_allowed(bool lhit, bool inl, bool inr) const {
     return (lhit && (!inr)) || ((!lhit) && (!inl));
 }
@@ -12,10 +14,36 @@ bool csgDifferenceOperator::intersection_allowed(bool lhit, bool inl, bool inr)
     return (lhit && (!inr)) || ((!lhit) && inl);
 }
 
+bool csgUnionOperator::requires_left() const {
+    return false;
+}
+
+bool csgUnionOperator::requires_right() const {
+    return false;
+}
+
+bool csgIntersectionOperator::requires_left() const {
+    return true;
+}
+
+bool csgIntersectionOperator::requires_right() const {
+    return true;
+}
+
+bool csgDifferenceOperator::requires_left() const {
+    return true;
+}
+
+bool csgDifferenceOperator::requires_right() const {
+    return false;
+}
+
 CSG::CSG(std::shared_ptr<csgOperator> op, ShapePtr left, ShapePtr right) :
     op_(op),
     left_(left),
-    right_(right)
+    right_(right),
+    left_csg_(dynamic_cast<const CSG*>(left.get())),
+    right_csg_(dynamic_cast<const CSG*>(right.get()))
 {}
 
 void CSG::init() {
@@ -45,15 +73,79 @@ void CSG::update_bounds() {
 //}
 
 
+// Scratch lists for the hits of the operands, two per level of CSG nesting. A deque keeps the
+// lists of the outer levels in place when a deeper level adds its own, and they keep their
+// capacity between rays so no allocation happens once they have grown.
+static thread_local std::deque<std::vector<Intersection>> scratch;
+static thread_local size_t scratch_depth = 0;
+
 void CSG::intersect(const Ray &r, std::vector<Intersection> &xs) const {
-    if (bounds.intersects(r)) {
-        std::vector<Intersection> ys;
-        r.intersect(left_, ys);
-        r.intersect(right_, ys);
-        std::sort(ys.begin(), ys.end());
-        filter_intersections(ys);
-        std::move(ys.begin(), ys.end(), std::back_inserter(xs));
-        std::sort(xs.begin(), xs.end()); // TODO: Is this sort needed?
+    if (bounds.intersects(r))
+        intersect(r, xs, -INF, INF);
+}
+
+// Only hits within [tmin, tmax] have to be right, an operand whose box the ray does not cross in there
+// can be left out: the remaining solid is the same within the interval, so are the inside states.
+// Hits on one operand that only count inside the other further shrink the interval of the first.
+void CSG::intersect(const Ray &r, std::vector<Intersection> &xs, float tmin, float tmax) const {
+    float l0, l1, r0, r1;
+    const bool lbox = left_->bounds_transform.intersects(r, &l0, &l1) && l1 >= tmin && l0 <= tmax;
+    if (!lbox && op_->requires_left())
+        return;
+    const bool rbox = right_->bounds_transform.intersects(r, &r0, &r1) && r1 >= tmin && r0 <= tmax;
+    if (!rbox && op_->requires_right())
+        return;
+    const float la = op_->requires_right() ? std::max(tmin, r0) : tmin;
+    const float lb = op_->requires_right() ? std::min(tmax, r1) : tmax;
+    const float ra = op_->requires_left() ? std::max(tmin, l0) : tmin;
+    const float rb = op_->requires_left() ? std::min(tmax, l1) : tmax;
+    const bool lhit = lbox && la <= lb && l1 >= la && l0 <= lb;
+    const bool rhit = rbox && ra <= rb && r1 >= ra && r0 <= rb;
+    if ((!lhit && op_->requires_left()) || (!rhit && op_->requires_right()))
+        return;
+
+    if (scratch.size() < scratch_depth + 2)
+        scratch.resize(scratch_depth + 2);
+    std::vector<Intersection> &ls = scratch[scratch_depth];
+    std::vector<Intersection> &rs = scratch[scratch_depth + 1];
+    ls.clear();
+    rs.clear();
+    scratch_depth += 2;
+    if (lhit)
+        intersect_operand(left_, left_csg_, r, ls, la, lb);
+    if (rhit)
+        intersect_operand(right_, right_csg_, r, rs, ra, rb);
+    scratch_depth -= 2;
+    // Most shapes already return their hits in order
+    if (!std::is_sorted(ls.begin(), ls.end()))
+        std::sort(ls.begin(), ls.end());
+    if (!std::is_sorted(rs.begin(), rs.end()))
+        std::sort(rs.begin(), rs.end());
+    merge_intersections(ls, rs, xs);
+}
+
+void CSG::intersect_operand(const ShapePtr &s, const CSG *csg, const Ray &r, std::vector<Intersection> &xs, float tmin, float tmax) const {
+    // Distances along the ray are the same in the space of the operand
+    if (csg)
+        csg->intersect(s->get_transform_inv() * r, xs, tmin, tmax);
+    else
+        r.intersect(s, xs);
+}
+
+// Walks both sorted lists in order and appends the hits the operator allows, which are sorted as well
+void CSG::merge_intersections(const std::vector<Intersection> &ls, const std::vector<Intersection> &rs, std::vector<Intersection> &xs) const {
+    bool inl = false;
+    bool inr = false;
+    size_t a = 0, b = 0;
+    while (a < ls.size() || b < rs.size()) {
+        const bool lhit = b == rs.size() || (a < ls.size() && !(rs[b] < ls[a]));
+        const Intersection &i = lhit ? ls[a++] : rs[b++];
+        if (op_->intersection_allowed(lhit, inl, inr))
+            xs.push_back(i);
+        if (lhit)
+            inl = !inl;
+        else
+            inr = !inr;
     }
 }
 
@@ -64,6 +156,12 @@ void CSG::divide(int threshold) {
     update_bounds();
 }
 
+void CSG::refit() {
+    left_->refit();
+    right_->refit();
+    update_bounds();
+}
+
 bool CSG::includes(const ShapePtr &s) const {
     return left_->includes(s) || right_->includes(s);
 }
@@ -71,17 +169,17 @@ bool CSG::includes(const ShapePtr &s) const {
 void CSG::filter_intersections(std::vector<Intersection> &xs) const {
     bool inl = false;
     bool inr = false;
-    std::vector<Intersection> res;
-    for (const Intersection &i : xs) {
-        bool lhit = left_->includes(std::const_pointer_cast<Shape>(i.get_shape()));
+    size_t kept = 0;
+    for (size_t k = 0; k < xs.size(); k++) {
+        const bool lhit = left_->includes(std::const_pointer_cast<Shape>(xs[k].get_shape()));
         if (op_->intersection_allowed(lhit, inl, inr))
-            res.push_back(i);
+            xs[kept++] = xs[k];
         if (lhit)
             inl = !inl;
         else
             inr = !inr;
     }
-    xs = res;
+    xs.erase(xs.begin() + kept, xs.end());
 }
 
 Tuple CSG::normal_at_local(const Tuple &p, const Intersection &i) const {
@@ -1,15 +1,33 @@
 #include "Group.hpp"
+#include "Stats.hpp"
+
+#include <unordered_set>
 
 Group::Group() {}
 
 void Group::intersect(const Ray &r, std::vector<Intersection> &xs) const {
+    STATS_NODE_VISIT();
     if (bounds.intersects(r)) {
+        const size_t first = xs.size();
+        STATS_ENTER_GROUP();
         for (const auto &child : members) {
             r.intersect(child, xs);
         }
+        STATS_LEAVE_GROUP();
+        if (unique_hits_)
+            remove_duplicates(xs, first);
     }
 }
 
+// The same primitive reached through different leaves is hit at the same distance
+void Group::remove_duplicates(std::vector<Intersection> &xs, size_t first) {
+    auto by_shape = [](const Intersection &a, const Intersection &b) {
+        return a.get_shape() < b.get_shape() || (a.get_shape() == b.get_shape() && a.get_distance() < b.get_distance());
+    };
+    std::sort(xs.begin() + first, xs.end(), by_shape);
+    xs.erase(std::unique(xs.begin() + first, xs.end()), xs.end());
+}
+
 Tuple Group::normal_at_local(const Tuple &p, const Intersection &i) const {
     throw std::runtime_error("A group does not have a normal vector!");
 }
@@ -35,8 +53,15 @@ size_t Group::count() const {
     return members.size();
 }
 
+// Also finds shapes in nested groups, like the subgroups created by divide()
 bool Group::includes(const ShapePtr &child) const {
-    return std::find(members.begin(), members.end(), child) != members.end();
+    return std::any_of(members.begin(), members.end(), [&child](const ShapePtr &member) {
+        return member == child || member->includes(child);
+    });
+}
+
+bool Group::is_aggregate() const {
+    return true;
 }
 
 void Group::update_bounds() {
@@ -79,12 +104,14 @@ void Group::divide(int threshold) {
 
         if (!left->empty()) {
             const std::shared_ptr<Group> subgroup = std::make_shared<Group>();
+            subgroup->bvh_node_ = true;
             for (int i = 0; i < left->count(); i++)
                 subgroup->add_child((*left)[i]);
             add_child(subgroup);
         }
         if (!right->empty()) {
             const std::shared_ptr<Group> subgroup = std::make_shared<Group>();
+            subgroup->bvh_node_ = true;
             for (int i = 0; i < right->count(); i++)
                 subgroup->add_child((*right)[i]);
             add_child(subgroup);
@@ -94,6 +121,69 @@ void Group::divide(int threshold) {
     for (auto child : members)
         child->divide(threshold);
     update_bounds();
+    build_cost_ = sah_cost();
+}
+
+void Group::divide(const BVHOptions &options) {
+    BVHBuilder(options).build(*this);
+}
+
+void Group::refit() {
+    for (auto &child : members)
+        child->refit();
+    update_bounds();
+}
+
+// Every time a group is entered its box is tested and all its non-group members are intersected
+float Group::node_cost() const {
+    float cost = 0.0f;
+    size_t n_primitives = 0;
+    for (const auto &child : members) {
+        const Group *subgroup = dynamic_cast<const Group*>(child.get());
+        if (subgroup)
+            cost += subgroup->node_cost();
+        else
+            n_primitives++;
+    }
+    return cost + bounds.surface_area() * (1.0f + n_primitives);
+}
+
+// Surface area heuristic of the hierarchy, normalized by the area of the root
+float Group::sah_cost() const {
+    const float area = bounds.surface_area();
+    if (area <= 0.0f)
+        return 0.0f;
+    return node_cost() / area;
+}
+
+void Group::flatten() {
+    std::vector<ShapePtr> leaves;
+    std::unordered_set<ShapePtr> seen;
+    std::vector<ShapePtr> stack(members.rbegin(), members.rend());
+    while (!stack.empty()) {
+        ShapePtr child = stack.back();
+        stack.pop_back();
+        const std::shared_ptr<Group> subgroup = std::dynamic_pointer_cast<Group>(child);
+        if (subgroup && subgroup->bvh_node_)
+            stack.insert(stack.end(), subgroup->members.rbegin(), subgroup->members.rend());
+        else if (seen.insert(child).second)
+            leaves.push_back(child);
+    }
+    members.clear();
+    unique_hits_ = false;
+    for (auto &leaf : leaves)
+        add_child(leaf, false);
+    update_bounds();
+}
+
+// Keeps the topology and only recomputes the bounds, unless the tree degraded too much since it was built
+bool Group::refit_or_rebuild(int threshold, float max_degradation) {
+    refit();
+    if (build_cost_ > 0.0f && sah_cost() <= build_cost_ * max_degradation)
+        return false;
+    flatten();
+    divide(threshold);
+    return true;
 }
 
 std::shared_ptr<Cube> Group::get_bbox() {
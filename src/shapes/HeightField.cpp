@@ -0,0 +1,178 @@
+#include "HeightField.hpp"
+
+HeightField::HeightField(uint32_t width, uint32_t depth, const std::vector<float> &heights) :
+    width_(width),
+    depth_(depth),
+    heights_(heights)
+{
+    assert(width >= 2 && depth >= 2);
+    assert(heights.size() == width * depth);
+
+    // Level 0 holds the cells, every next one blocks of 2x2 of the previous until a single one is left
+    Level cells = {width_ - 1, depth_ - 1, {}};
+    for (uint32_t j = 0; j < cells.depth; j++) {
+        for (uint32_t i = 0; i < cells.width; i++) {
+            const float h[4] = {height(i, j), height(i + 1, j), height(i, j + 1), height(i + 1, j + 1)};
+            cells.ranges.push_back({*std::min_element(h, h + 4), *std::max_element(h, h + 4)});
+        }
+    }
+    levels_.push_back(cells);
+    while (levels_.back().width > 1 || levels_.back().depth > 1) {
+        const Level &below = levels_.back();
+        Level level = {(below.width + 1) / 2, (below.depth + 1) / 2, {}};
+        for (uint32_t j = 0; j < level.depth; j++) {
+            for (uint32_t i = 0; i < level.width; i++) {
+                Range range = {INF, -INF};
+                for (uint32_t cj = 2 * j; cj < std::min(2 * j + 2, below.depth); cj++) {
+                    for (uint32_t ci = 2 * i; ci < std::min(2 * i + 2, below.width); ci++) {
+                        range.min = std::min(range.min, below.ranges[cj * below.width + ci].min);
+                        range.max = std::max(range.max, below.ranges[cj * below.width + ci].max);
+                    }
+                }
+                level.ranges.push_back(range);
+            }
+        }
+        levels_.push_back(level);
+    }
+
+    const Range &all = levels_.back().ranges[0];
+    bounds = Bounds(Point(-1.0f, all.min, -1.0f), Point(1.0f, all.max, 1.0f));
+    bounds_transform = bounds;
+}
+
+std::shared_ptr<HeightField> HeightField::from_canvas(const Canvas &canvas) {
+    std::vector<float> heights;
+    for (uint32_t z = 0; z < canvas.get_height(); z++) {
+        for (uint32_t x = 0; x < canvas.get_width(); x++) {
+            const Color c = canvas.get_pixel(x, z);
+            heights.push_back((c.red() + c.green() + c.blue()) / 3.0f);
+        }
+    }
+    return std::make_shared<HeightField>(canvas.get_width(), canvas.get_height(), heights);
+}
+
+float HeightField::height(uint32_t x, uint32_t z) const {
+    return heights_[z * width_ + x];
+}
+
+uint32_t HeightField::width() const {
+    return width_;
+}
+
+uint32_t HeightField::depth() const {
+    return depth_;
+}
+
+Tuple HeightField::vertex(uint32_t x, uint32_t z) const {
+    return Point(-1.0f + 2.0f * x / (width_ - 1), height(x, z), -1.0f + 2.0f * z / (depth_ - 1));
+}
+
+void HeightField::intersect(const Ray &r, std::vector<Intersection> &xs) const {
+    float t0, t1;
+    if (!bounds.intersects(r, &t0, &t1))
+        return;
+    traverse(r, (int) levels_.size() - 1, 0, 0, t0, t1, xs);
+}
+
+// Visits block (i, j) of a level for the part [t0, t1] of the ray above it
+void HeightField::traverse(const Ray &r, int level, uint32_t i, uint32_t j, float t0, float t1, std::vector<Intersection> &xs) const {
+    const Tuple o = r.get_origin();
+    const Tuple d = r.get_direction();
+    const float y0 = o.get_y() + d.get_y() * t0;
+    const float y1 = o.get_y() + d.get_y() * t1;
+    const Range &range = levels_[level].ranges[j * levels_[level].width + i];
+    if (std::max(y0, y1) < range.min || std::min(y0, y1) > range.max)
+        return;
+    if (level == 0) {
+        intersect_cell(r, i, j, xs);
+        return;
+    }
+
+    // The children split the block at these cells, if the second child exists along the axis
+    const Level &below = levels_[level - 1];
+    const uint32_t cells = 1u << (level - 1);
+    const uint32_t mid_x = (2 * i + 1) * cells;
+    const uint32_t mid_z = (2 * j + 1) * cells;
+    const bool split_x = 2 * i + 1 < below.width;
+    const bool split_z = 2 * j + 1 < below.depth;
+    const float plane_x = -1.0f + 2.0f * mid_x / (width_ - 1);
+    const float plane_z = -1.0f + 2.0f * mid_z / (depth_ - 1);
+    float tx = split_x && d.get_x() != 0.0f ? (plane_x - o.get_x()) / d.get_x() : INF;
+    float tz = split_z && d.get_z() != 0.0f ? (plane_z - o.get_z()) / d.get_z() : INF;
+
+    // Start in the child the ray enters first and switch sides at the planes
+    const float ts = t0 + 1e-4f * (t1 - t0);
+    uint32_t ci = 2 * i + (split_x && o.get_x() + d.get_x() * ts >= plane_x ? 1 : 0);
+    uint32_t cj = 2 * j + (split_z && o.get_z() + d.get_z() * ts >= plane_z ? 1 : 0);
+    if (tx <= t0)
+        tx = INF;
+    if (tz <= t0)
+        tz = INF;
+    // A ray along y passes the block in a single point, that still needs the child below it
+    float t = t0;
+    do {
+        const bool cross_x = tx <= tz;
+        const float next = std::min(std::min(tx, tz), t1);
+        traverse(r, level - 1, ci, cj, t, next, xs);
+        t = next;
+        if (cross_x) {
+            ci ^= 1;
+            tx = INF;
+        } else {
+            cj ^= 1;
+            tz = INF;
+        }
+    } while (t < t1);
+}
+
+// Moller-Trumbore on the two triangles of the cell
+void HeightField::intersect_cell(const Ray &r, uint32_t i, uint32_t j, std::vector<Intersection> &xs) const {
+    const Tuple p00 = vertex(i, j), p10 = vertex(i + 1, j), p01 = vertex(i, j + 1), p11 = vertex(i + 1, j + 1);
+    const Tuple triangles[2][3] = {{p00, p10, p11}, {p00, p11, p01}};
+    const Tuple o = r.get_origin();
+    const Tuple d = r.get_direction();
+    for (const auto &tri : triangles) {
+        const Tuple e1 = tri[1] - tri[0];
+        const Tuple e2 = tri[2] - tri[0];
+        const Tuple pvec = d.cross(e2);
+        const float det = e1.dot(pvec);
+        if (std::abs(det) < mEpsilon)
+            continue;
+        const float inv_det = 1.0f / det;
+        const Tuple tvec = o - tri[0];
+        const float u = tvec.dot(pvec) * inv_det;
+        if (u < 0.0f || u > 1.0f)
+            continue;
+        const Tuple qvec = tvec.cross(e1);
+        const float v = d.dot(qvec) * inv_det;
+        if (v < 0.0f || u + v > 1.0f)
+            continue;
+        xs.push_back({e2.dot(qvec) * inv_det, shared_from_this()});
+    }
+}
+
+// The gradient of the grid at a sample, one sided at the borders
+Tuple HeightField::vertex_normal(uint32_t x, uint32_t z) const {
+    const uint32_t x0 = x > 0 ? x - 1 : x, x1 = std::min(x + 1, width_ - 1);
+    const uint32_t z0 = z > 0 ? z - 1 : z, z1 = std::min(z + 1, depth_ - 1);
+    const float dx = 2.0f * (x1 - x0) / (width_ - 1);
+    const float dz = 2.0f * (z1 - z0) / (depth_ - 1);
+    return Vector(-(height(x1, z) - height(x0, z)) / dx, 1.0f, -(height(x, z1) - height(x, z0)) / dz);
+}
+
+// Bilinear interpolation of the normals at the corners of the cell of the point
+Tuple HeightField::normal_at_local(const Tuple &p, const Intersection &i) const {
+    const float fx = std::clamp((p.get_x() + 1.0f) * 0.5f * (width_ - 1), 0.0f, (float) (width_ - 1));
+    const float fz = std::clamp((p.get_z() + 1.0f) * 0.5f * (depth_ - 1), 0.0f, (float) (depth_ - 1));
+    const uint32_t x = std::min((uint32_t) fx, width_ - 2);
+    const uint32_t z = std::min((uint32_t) fz, depth_ - 2);
+    const float s = fx - x, t = fz - z;
+    const Tuple n = vertex_normal(x, z) * ((1 - s) * (1 - t)) + vertex_normal(x + 1, z) * (s * (1 - t)) +
+                    vertex_normal(x, z + 1) * ((1 - s) * t) + vertex_normal(x + 1, z + 1) * (s * t);
+    return n.normalize();
+}
+
+bool HeightField::operator==(const Shape &rhs) const {
+    const HeightField *rhs_field = dynamic_cast<const HeightField*>(&rhs);
+    return rhs_field && rhs_field->width_ == width_ && rhs_field->depth_ == depth_ && rhs_field->heights_ == heights_ && Shape::operator==(rhs);
+}
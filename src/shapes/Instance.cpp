@@ -0,0 +1,43 @@
+#include "Instance.hpp"
+
+Instance::Instance(const ShapePtr &prototype) :
+    prototype_(prototype)
+{
+    assert(prototype_->get_parent() == nullptr);
+    // The material of the prototype acts as default, set_material() overrides it per instance
+    set_material_id(prototype_->get_material_id());
+    bounds = prototype_->bounds_transform;
+    bounds_transform = bounds;
+}
+
+void Instance::intersect(const Ray &r, std::vector<Intersection> &xs) const {
+    if (!bounds.intersects(r))
+        return;
+
+    // Hits are appended in place and then re-targeted, the primitive that was hit is kept as leaf
+    const size_t first = xs.size();
+    r.intersect(prototype_, xs);
+    const ShapeConstPtr self = shared_from_this();
+    for (size_t i = first; i < xs.size(); i++)
+        xs[i] = Intersection(xs[i], self);
+}
+
+// The point is in the object space of the instance, which is the world space of the prototype
+Tuple Instance::normal_at_local(const Tuple &p, const Intersection &i) const {
+    return i.get_leaf()->normal_at(p, i);
+}
+
+bool Instance::operator==(const Shape &rhs) const {
+    const Instance *rhs_instance = dynamic_cast<const Instance*>(&rhs);
+    return rhs_instance && rhs_instance->prototype_ == prototype_ && Shape::operator==(rhs);
+}
+
+// The prototype is shared, it has to be refit by its owner before its instances are
+void Instance::refit() {
+    bounds = prototype_->bounds_transform;
+    Shape::refit();
+}
+
+ShapePtr Instance::prototype() const {
+    return prototype_;
+}
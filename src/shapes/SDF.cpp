@@ -0,0 +1,203 @@
+#include "SDF.hpp"
+
+#include <cmath>
+#include <typeinfo>
+
+SDF::SDF(const Bounds &b) :
+    epsilon_(SDF_EPSILON),
+    max_steps_(SDF_MAX_STEPS),
+    relaxation_(SDF_RELAXATION)
+{
+    bounds = b;
+    bounds_transform = bounds;
+}
+
+void SDF::intersect(const Ray &r, std::vector<Intersection> &xs) const {
+    float t0, t1;
+    if (!bounds.intersects(r, &t0, &t1) || !(t1 > std::max(t0, 0.0f)))
+        return;
+
+    // Distances are measured in object space, the ray is not normalized there
+    const float len = r.get_direction().magnitude();
+    // Surfaces may touch the bounds, the last steps towards them are allowed to go a bit beyond
+    const float t_end = t1 + 2.0f * epsilon_ / len;
+    float t = t0;
+    float sign = distance(r.position(t)) < 0.0f ? -1.0f : 1.0f;
+    float omega = relaxation_;
+    float prev_radius = 0.0f;
+    float step = 0.0f;
+    // After a hit the next one only counts once the ray got away from the surface
+    bool armed = true;
+    for (int i = 0; i < max_steps_ && t <= t_end; i++) {
+        const float radius = sign * distance(r.position(t));
+        // The relaxed step went too far if the spheres at both ends do not overlap, step back
+        if (omega > 1.0f && radius + prev_radius < step) {
+            t -= (step - prev_radius) / len;
+            step = prev_radius;
+            omega = 1.0f;
+            continue;
+        }
+        if (radius < epsilon_) {
+            if (armed) {
+                // Look for the next crossing from the other side
+                xs.push_back({t, shared_from_this()});
+                sign = -sign;
+                armed = false;
+                omega = relaxation_;
+            }
+            // Nothing to step back to from here
+            prev_radius = 0.0f;
+            step = 0.0f;
+            t += epsilon_ / len;
+            continue;
+        }
+        armed = true;
+        prev_radius = radius;
+        step = radius * omega;
+        // Past the bounds a step that went too far could no longer be taken back
+        if (t + step / len > t_end)
+            step = radius;
+        t += step / len;
+    }
+}
+
+// Central differences of the field
+Tuple SDF::normal_at_local(const Tuple &p, const Intersection &i) const {
+    const float h = epsilon_;
+    const Tuple dx = Vector(h, 0.0f, 0.0f), dy = Vector(0.0f, h, 0.0f), dz = Vector(0.0f, 0.0f, h);
+    return Vector(distance(p + dx) - distance(p - dx),
+                  distance(p + dy) - distance(p - dy),
+                  distance(p + dz) - distance(p - dz)).normalize();
+}
+
+bool SDF::operator==(const Shape &rhs) const {
+    return typeid(*this) == typeid(rhs) && Shape::operator==(rhs);
+}
+
+void SDF::set_epsilon(float epsilon) {
+    epsilon_ = epsilon;
+}
+
+void SDF::set_max_steps(int max_steps) {
+    max_steps_ = max_steps;
+}
+
+void SDF::set_relaxation(float relaxation) {
+    relaxation_ = relaxation;
+}
+
+SDFSphere::SDFSphere() :
+    SDF(Bounds(Point(-1.0f, -1.0f, -1.0f), Point(1.0f, 1.0f, 1.0f)))
+{}
+
+float SDFSphere::distance(const Tuple &p) const {
+    return Vector(p.get_x(), p.get_y(), p.get_z()).magnitude() - 1.0f;
+}
+
+SDFMandelbulb::SDFMandelbulb(float power, int iterations) :
+    SDF(Bounds(Point(-1.2f, -1.2f, -1.2f), Point(1.2f, 1.2f, 1.2f))),
+    power_(power),
+    iterations_(iterations)
+{}
+
+// http://blog.hvidtfeldts.net/index.php/2011/09/distance-estimated-3d-fractals-v-the-mandelbulb-different-de-approximations/
+float SDFMandelbulb::distance(const Tuple &p) const {
+    float x = p.get_x(), y = p.get_y(), z = p.get_z();
+    float dr = 1.0f;
+    float r = 0.0f;
+    for (int i = 0; i < iterations_; i++) {
+        r = std::sqrt(x * x + y * y + z * z);
+        if (r > 2.0f)
+            break;
+        if (r < 1e-6f)
+            return -1e-6f;
+        const float theta = std::acos(z / r) * power_;
+        const float phi = std::atan2(y, x) * power_;
+        const float zr = std::pow(r, power_);
+        dr = std::pow(r, power_ - 1.0f) * power_ * dr + 1.0f;
+        x = zr * std::sin(theta) * std::cos(phi) + p.get_x();
+        y = zr * std::sin(theta) * std::sin(phi) + p.get_y();
+        z = zr * std::cos(theta) + p.get_z();
+    }
+    return 0.5f * std::log(r) * r / dr;
+}
+
+bool SDFMandelbulb::operator==(const Shape &rhs) const {
+    const SDFMandelbulb *rhs_bulb = dynamic_cast<const SDFMandelbulb*>(&rhs);
+    return rhs_bulb && rhs_bulb->power_ == power_ && rhs_bulb->iterations_ == iterations_ && Shape::operator==(rhs);
+}
+
+SDFJulia::SDFJulia(const Tuple &c, float w, int iterations) :
+    SDF(Bounds(Point(-1.5f, -1.5f, -1.5f), Point(1.5f, 1.5f, 1.5f))),
+    c_(c),
+    w_(w),
+    iterations_(iterations)
+{}
+
+// Iterates q = q^2 + c along with the derivative dq = 2 q dq, both quaternions stored as (x, y, z, w)
+float SDFJulia::distance(const Tuple &p) const {
+    float q[4] = {p.get_x(), p.get_y(), p.get_z(), w_};
+    float dq[4] = {1.0f, 0.0f, 0.0f, 0.0f};
+    float r2 = 0.0f;
+    for (int i = 0; i < iterations_; i++) {
+        // Scalar part is the fourth component
+        const float d[4] = {2.0f * (q[3] * dq[0] + q[0] * dq[3] + q[1] * dq[2] - q[2] * dq[1]),
+                            2.0f * (q[3] * dq[1] - q[0] * dq[2] + q[1] * dq[3] + q[2] * dq[0]),
+                            2.0f * (q[3] * dq[2] + q[0] * dq[1] - q[1] * dq[0] + q[2] * dq[3]),
+                            2.0f * (q[3] * dq[3] - q[0] * dq[0] - q[1] * dq[1] - q[2] * dq[2])};
+        const float s[4] = {2.0f * q[3] * q[0] + c_[0],
+                            2.0f * q[3] * q[1] + c_[1],
+                            2.0f * q[3] * q[2] + c_[2],
+                            q[3] * q[3] - q[0] * q[0] - q[1] * q[1] - q[2] * q[2] + c_[3]};
+        std::copy(d, d + 4, dq);
+        std::copy(s, s + 4, q);
+        r2 = q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3];
+        if (r2 > 16.0f)
+            break;
+    }
+    const float r = std::sqrt(r2);
+    const float dr = std::sqrt(dq[0] * dq[0] + dq[1] * dq[1] + dq[2] * dq[2] + dq[3] * dq[3]);
+    return 0.5f * r * std::log(r) / dr;
+}
+
+bool SDFJulia::operator==(const Shape &rhs) const {
+    const SDFJulia *rhs_julia = dynamic_cast<const SDFJulia*>(&rhs);
+    return rhs_julia && rhs_julia->c_ == c_ && rhs_julia->w_ == w_ && rhs_julia->iterations_ == iterations_ && Shape::operator==(rhs);
+}
+
+// The smallest factor by which a transform stretches an axis
+static float min_scale(const Matrix<4, 4> &m) {
+    return std::min({(m * Vector(1.0f, 0.0f, 0.0f)).magnitude(),
+                     (m * Vector(0.0f, 1.0f, 0.0f)).magnitude(),
+                     (m * Vector(0.0f, 0.0f, 1.0f)).magnitude()});
+}
+
+// The smooth minimum is at most k / 4 below the minimum, that is how far the surface can grow
+static Bounds blend_bounds(const std::shared_ptr<SDF> &a, const std::shared_ptr<SDF> &b, float k) {
+    Bounds box = a->bounds_transform;
+    box.merge(b->bounds_transform);
+    const Tuple grow = Vector(0.25f * k, 0.25f * k, 0.25f * k);
+    return Bounds(box.min() - grow, box.max() + grow);
+}
+
+SDFBlend::SDFBlend(const std::shared_ptr<SDF> &a, const std::shared_ptr<SDF> &b, float k) :
+    SDF(blend_bounds(a, b, k)),
+    a_(a),
+    b_(b),
+    k_(k),
+    scale_a_(min_scale(a->get_transform())),
+    scale_b_(min_scale(b->get_transform()))
+{}
+
+// https://iquilezles.org/articles/smin/
+float SDFBlend::distance(const Tuple &p) const {
+    const float da = a_->distance(a_->get_transform_inv() * p) * scale_a_;
+    const float db = b_->distance(b_->get_transform_inv() * p) * scale_b_;
+    const float h = std::clamp(0.5f + 0.5f * (db - da) / k_, 0.0f, 1.0f);
+    return db + (da - db) * h - k_ * h * (1.0f - h);
+}
+
+bool SDFBlend::operator==(const Shape &rhs) const {
+    const SDFBlend *rhs_blend = dynamic_cast<const SDFBlend*>(&rhs);
+    return rhs_blend && *rhs_blend->a_ == *a_ && *rhs_blend->b_ == *b_ && rhs_blend->k_ == k_ && Shape::operator==(rhs);
+}
@@ -1,20 +1,61 @@
 #include "Shape.hpp"
 
+#include <atomic>
+
+static std::atomic<uint64_t> transforms_changed(0);
+
 Shape::Shape() :
     transform(Matrix<4, 4>::identity()),
     transform_inv(Matrix<4, 4>::identity()),
-    material(),
     parent(),
     bounds(),
-    bounds_transform()
+    bounds_transform(),
+    material_id(0)
 {}
 
+// A copy shares the material with the original
+Shape::Shape(const Shape &s) :
+    std::enable_shared_from_this<Shape>(s),
+    bounds_transform(s.bounds_transform),
+    bounds(s.bounds),
+    transform(s.transform),
+    transform_inv(s.transform_inv),
+    parent(s.parent),
+    material_id(s.material_id)
+{
+    MaterialTable::acquire(material_id);
+}
+
+Shape::~Shape() {
+    MaterialTable::release(material_id);
+}
+
+Shape& Shape::operator=(const Shape &s) {
+    bounds_transform = s.bounds_transform;
+    bounds = s.bounds;
+    transform = s.transform;
+    transform_inv = s.transform_inv;
+    parent = s.parent;
+    set_material_id(s.material_id);
+    transforms_changed.fetch_add(1, std::memory_order_release);
+    return *this;
+}
+
+ShapeConstPtr Shape::get_parent() const {
+    return parent;
+}
+
 ShapePtr Shape::get_parent() {
     return parent;
 }
 
 void Shape::set_parent(ShapePtr parent_n) {
     parent = parent_n;
+    transforms_changed.fetch_add(1, std::memory_order_release);
+}
+
+uint64_t Shape::transform_generation() {
+    return transforms_changed.load(std::memory_order_acquire);
 }
 
 void Shape::set_bounds(const Bounds &b) {
@@ -41,6 +82,7 @@ void Shape::set_transform(const Matrix<4, 4> &t) {
     transform = t;
     bounds_transform = bounds * transform;
     transform_inv = t.inverse();
+    transforms_changed.fetch_add(1, std::memory_order_release);
 }
 
 Tuple Shape::normal_at(const Tuple &p, const Intersection &i) const {
@@ -68,21 +110,40 @@ Tuple Shape::world_to_object(const Tuple &world_p) const {
     return transform_inv * p;
 }
 
-const Material& Shape::get_material() const {
-    return material;
-}
-
 void Shape::set_material(const Material &m) {
-    material = m;
+    if (MaterialTable::is_shared(material_id)) {
+        const uint32_t id = MaterialTable::add(m);
+        MaterialTable::release(material_id);
+        material_id = id;
+    } else {
+        MaterialTable::mod(material_id) = m;
+    }
 }
 
+// Copy on write, modifying a material other shapes refer to gives the shape its own copy
 Material& Shape::mod_material() {
-    return material;
+    if (MaterialTable::is_shared(material_id)) {
+        const uint32_t id = MaterialTable::add(MaterialTable::get(material_id));
+        MaterialTable::release(material_id);
+        material_id = id;
+    }
+    return MaterialTable::mod(material_id);
+}
+
+// Acquires before releasing, so setting the id the shape already has keeps the entry alive
+void Shape::set_material_id(uint32_t id) {
+    MaterialTable::acquire(id);
+    MaterialTable::release(material_id);
+    material_id = id;
+}
+
+uint32_t Shape::get_material_id() const {
+    return material_id;
 }
 
 bool Shape::is_equal(const Shape &rhs) const {
     // TODO: Expand
-    return material == rhs.get_material() &&
+    return get_material() == rhs.get_material() &&
            transform == rhs.get_transform() &&
            transform_inv == rhs.get_transform_inv();
 }
@@ -95,9 +156,18 @@ void Shape::divide(int threshold) {
     ;
 }
 
+// Leaves only have to follow their own transform, containers recompute their bounds bottom-up
+void Shape::refit() {
+    bounds_transform = bounds * transform;
+}
+
+// Membership is by identity, two equal shapes are still different members
 bool Shape::includes(const ShapePtr &s) const {
-    // TODO: Check this!
-    return *this == *s;
+    return this == s.get();
+}
+
+bool Shape::is_aggregate() const {
+    return false;
 }
 
 void Shape::UVMappedPoint(const Tuple &p, float *u, float *v) const {
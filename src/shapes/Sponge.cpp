@@ -0,0 +1,135 @@
+#include "Sponge.hpp"
+
+#include <cmath>
+
+// Solid spans closer than this are one, the faces between the cells of a level are not surfaces
+constexpr double SPONGE_MERGE_EPSILON = 1e-9;
+
+Sponge::Sponge(int level) :
+    level_(level)
+{
+    assert(level >= 0);
+    bounds = Bounds(Point(-1.0f, -1.0f, -1.0f), Point(1.0f, 1.0f, 1.0f));
+    bounds_transform = bounds;
+}
+
+// A cell is removed if it is in the middle along at least two axes
+bool Sponge::is_solid(int ix, int iy, int iz) {
+    return (ix == 1) + (iy == 1) + (iz == 1) < 2;
+}
+
+void Sponge::intersect(const Ray &r, std::vector<Intersection> &xs) const {
+    Traversal tr;
+    tr.open = false;
+    Span span = {-INF, INF, 0, 0};
+    for (int a = 0; a < 3; a++) {
+        tr.o[a] = r.get_origin()[a];
+        tr.d[a] = r.get_direction()[a];
+        tr.step[a] = tr.d[a] > 0.0 ? 1 : (tr.d[a] < 0.0 ? -1 : 0);
+        if (tr.step[a] == 0) {
+            if (tr.o[a] < -1.0 || tr.o[a] > 1.0)
+                return;
+            continue;
+        }
+        double t1 = (-1.0 - tr.o[a]) / tr.d[a];
+        double t2 = (1.0 - tr.o[a]) / tr.d[a];
+        if (t1 > t2)
+            std::swap(t1, t2);
+        if (t1 > span.t0) {
+            span.t0 = t1;
+            span.axis0 = a;
+        }
+        if (t2 < span.t1) {
+            span.t1 = t2;
+            span.axis1 = a;
+        }
+    }
+    if (!(span.t1 > std::max(span.t0, 0.0)))
+        return;
+
+    const double lo[3] = {-1.0, -1.0, -1.0};
+    traverse(tr, lo, 2.0, 0, span, xs);
+    close_span(tr, xs);
+}
+
+// Walks the cells of the cell at lo through which the ray passes during span with a 3D DDA
+void Sponge::traverse(Traversal &tr, const double *lo, double size, int depth, const Span &span, std::vector<Intersection> &xs) const {
+    if (depth == level_) {
+        add_span(tr, span, xs);
+        return;
+    }
+
+    const double cell = size / 3.0;
+    // The first cell is found from a point just after the entry, which itself is on a boundary
+    const double te = span.t0 + 1e-6 * (span.t1 - span.t0);
+    int idx[3];
+    double t_next[3], t_delta[3];
+    for (int a = 0; a < 3; a++) {
+        const double p = tr.o[a] + tr.d[a] * te;
+        idx[a] = std::clamp((int) std::floor((p - lo[a]) / cell), 0, 2);
+        if (tr.step[a] == 0) {
+            t_next[a] = INF;
+            t_delta[a] = INF;
+        } else {
+            const double plane = lo[a] + (idx[a] + (tr.step[a] > 0 ? 1 : 0)) * cell;
+            t_next[a] = (plane - tr.o[a]) / tr.d[a];
+            t_delta[a] = cell / std::abs(tr.d[a]);
+        }
+    }
+
+    Span sub = {span.t0, 0.0, span.axis0, 0};
+    while (true) {
+        const int a = t_next[0] < t_next[1] ? (t_next[0] < t_next[2] ? 0 : 2) : (t_next[1] < t_next[2] ? 1 : 2);
+        const bool last = t_next[a] >= span.t1;
+        sub.t1 = last ? span.t1 : t_next[a];
+        sub.axis1 = last ? span.axis1 : a;
+        if (sub.t1 > sub.t0 && is_solid(idx[0], idx[1], idx[2])) {
+            const double sub_lo[3] = {lo[0] + idx[0] * cell, lo[1] + idx[1] * cell, lo[2] + idx[2] * cell};
+            traverse(tr, sub_lo, cell, depth + 1, sub, xs);
+        }
+        if (last)
+            break;
+        idx[a] += tr.step[a];
+        if (idx[a] < 0 || idx[a] > 2)
+            break;
+        t_next[a] += t_delta[a];
+        sub.t0 = sub.t1;
+        sub.axis0 = a;
+    }
+}
+
+// Solid spans arrive in order along the ray, touching ones are merged before their ends become hits
+void Sponge::add_span(Traversal &tr, const Span &span, std::vector<Intersection> &xs) const {
+    if (tr.open && span.t0 <= tr.span.t1 + SPONGE_MERGE_EPSILON) {
+        tr.span.t1 = span.t1;
+        tr.span.axis1 = span.axis1;
+        return;
+    }
+    close_span(tr, xs);
+    tr.span = span;
+    tr.open = true;
+}
+
+void Sponge::close_span(Traversal &tr, std::vector<Intersection> &xs) const {
+    if (!tr.open)
+        return;
+    const int a0 = tr.span.axis0, a1 = tr.span.axis1;
+    xs.push_back({static_cast<float>(tr.span.t0), shared_from_this(), static_cast<float>(a0), static_cast<float>(-tr.step[a0])});
+    xs.push_back({static_cast<float>(tr.span.t1), shared_from_this(), static_cast<float>(a1), static_cast<float>(tr.step[a1])});
+    tr.open = false;
+}
+
+Tuple Sponge::normal_at_local(const Tuple &p, const Intersection &i) const {
+    Tuple n = Vector(0.0f, 0.0f, 0.0f);
+    n[static_cast<int>(i.u())] = i.v();
+    return n;
+}
+
+bool Sponge::operator==(const Shape &rhs) const {
+    const Sponge *rhs_sponge = dynamic_cast<const Sponge*>(&rhs);
+    return rhs_sponge && rhs_sponge->level_ == level_ && Shape::operator==(rhs);
+}
+
+int Sponge::level() const {
+    return level_;
+}
@@ -0,0 +1,336 @@
+#include "WideBVH.hpp"
+#include "Stats.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Number of primitives a leaf slot can reference
+constexpr size_t MAX_LEAF_SIZE = 255;
+
+static bool is_finite(const Bounds &b) {
+    for (int a = 0; a < 3; a++) {
+        if (!std::isfinite(b.min()[a]) || !std::isfinite(b.max()[a]))
+            return false;
+    }
+    return true;
+}
+
+// Only the structure of a hierarchy is collapsed, a group that moves its members is a primitive
+static std::shared_ptr<Group> collapsible(const ShapePtr &s) {
+    const std::shared_ptr<Group> g = std::dynamic_pointer_cast<Group>(s);
+    if (g && g->get_transform() == Matrix<4, 4>::identity())
+        return g;
+    return nullptr;
+}
+
+template <int N>
+WideBVH<N>::WideBVH(const std::shared_ptr<Group> &group) :
+    unique_hits_(group->unique_hits_)
+{
+    set_transform(group->get_transform());
+    set_material_id(group->get_material_id());
+    Bounds box;
+    if (!group->empty())
+        build_node(group->members, &box);
+    for (const auto &u : unbounded_)
+        box.merge(u->bounds_transform);
+    bounds = box;
+    bounds_transform = bounds * get_transform();
+}
+
+template <int N>
+void WideBVH<N>::init() {
+    for (const auto &prim : prims_)
+        prim->set_parent(shared_from_this());
+    for (const auto &u : unbounded_)
+        u->set_parent(shared_from_this());
+}
+
+// Builds the node for a list of members and returns its index, box is set to its bounds
+template <int N>
+int WideBVH<N>::build_node(std::vector<ShapePtr> items, Bounds *box) {
+    // Pull in the members of the largest subgroups as long as they fit in the node
+    while (items.size() < N) {
+        int best = -1;
+        float best_area = -1.0f;
+        for (size_t i = 0; i < items.size(); i++) {
+            const std::shared_ptr<Group> g = collapsible(items[i]);
+            if (g && !g->empty() && items.size() + g->count() - 1 <= N && g->bounds.surface_area() > best_area) {
+                best_area = g->bounds.surface_area();
+                best = (int) i;
+            }
+        }
+        if (best < 0)
+            break;
+        const std::shared_ptr<Group> g = collapsible(items[best]);
+        items.erase(items.begin() + best);
+        items.insert(items.end(), g->members.begin(), g->members.end());
+    }
+
+    // Every slot is either a leaf holding primitives or a list of members for a child node
+    std::vector<std::vector<ShapePtr>> leaves, inner;
+    std::vector<ShapePtr> loose;
+    for (const auto &item : items) {
+        const std::shared_ptr<Group> g = collapsible(item);
+        if (!g) {
+            loose.push_back(item);
+        } else if (!g->empty()) {
+            const bool flat = g->count() <= MAX_LEAF_SIZE &&
+                std::none_of(g->members.begin(), g->members.end(), [](const ShapePtr &s) { return collapsible(s); });
+            (flat ? leaves : inner).push_back(g->members);
+        }
+    }
+    for (size_t i = 0; i < loose.size(); i += MAX_LEAF_SIZE)
+        leaves.emplace_back(loose.begin() + i, loose.begin() + std::min(loose.size(), i + MAX_LEAF_SIZE));
+    // Planes and other unbounded primitives are taken out of the leaves
+    for (auto &leaf : leaves) {
+        auto bounded = std::stable_partition(leaf.begin(), leaf.end(), [](const ShapePtr &s) { return is_finite(s->bounds_transform); });
+        unbounded_.insert(unbounded_.end(), bounded, leaf.end());
+        leaf.erase(bounded, leaf.end());
+    }
+    leaves.erase(std::remove_if(leaves.begin(), leaves.end(), [](const std::vector<ShapePtr> &l) { return l.empty(); }), leaves.end());
+    // Slots that do not fit are moved to a child node of their own
+    while (leaves.size() + inner.size() > N) {
+        std::vector<ShapePtr> rest;
+        const size_t keep = N - 1;
+        while (leaves.size() + inner.size() > keep) {
+            std::vector<ShapePtr> &slot = inner.empty() ? leaves.back() : inner.back();
+            if (inner.empty()) {
+                // A leaf is moved as a new group so it stays a leaf below
+                const std::shared_ptr<Group> g = std::make_shared<Group>();
+                g->members = slot;
+                g->update_bounds();
+                rest.push_back(g);
+                leaves.pop_back();
+            } else {
+                rest.insert(rest.end(), slot.begin(), slot.end());
+                inner.pop_back();
+            }
+        }
+        inner.push_back(rest);
+    }
+
+    const int index = (int) nodes_.size();
+    nodes_.emplace_back();
+    Node node;
+    std::memset(&node, 0, sizeof(Node));
+    Bounds boxes[N];
+    int slot = 0;
+    for (const auto &leaf : leaves) {
+        node.child[slot] = ~((int32_t) prims_.size());
+        node.count[slot] = (uint8_t) leaf.size();
+        for (const auto &prim : leaf) {
+            boxes[slot].merge(prim->bounds_transform);
+            prims_.push_back(prim);
+        }
+        slot++;
+    }
+    for (const auto &members : inner) {
+        const int child = build_node(members, &boxes[slot]);
+        if (child < 0)
+            continue;
+        node.child[slot] = child;
+        slot++;
+    }
+    if (slot == 0) {
+        nodes_.pop_back();
+        return -1;
+    }
+
+    *box = Bounds();
+    for (int i = 0; i < slot; i++) {
+        node.valid |= 1u << i;
+        box->merge(boxes[i]);
+    }
+    quantize(node, boxes, *box);
+    nodes_[index] = node;
+    return index;
+}
+
+// Stores the child boxes relative to box, rounded outwards so they always contain the originals
+template <int N>
+void WideBVH<N>::quantize(Node &node, const Bounds *boxes, const Bounds &box) const {
+    for (int a = 0; a < 3; a++) {
+        const float origin = box.min()[a];
+        float scale = (box.max()[a] - origin) / 255.0f;
+        while (origin + 255.0f * scale < box.max()[a])
+            scale = std::nextafter(scale, INF);
+        node.origin[a] = origin;
+        node.scale[a] = scale;
+        for (int i = 0; i < N; i++) {
+            if (!(node.valid & (1u << i)) || scale == 0.0f) {
+                node.lo[a][i] = 0;
+                node.hi[a][i] = 0;
+                continue;
+            }
+            int lo = std::clamp((int) std::floor((boxes[i].min()[a] - origin) / scale), 0, 255);
+            int hi = std::clamp((int) std::ceil((boxes[i].max()[a] - origin) / scale), 0, 255);
+            while (lo > 0 && origin + lo * scale > boxes[i].min()[a])
+                lo--;
+            while (hi < 255 && origin + hi * scale < boxes[i].max()[a])
+                hi++;
+            node.lo[a][i] = (uint8_t) lo;
+            node.hi[a][i] = (uint8_t) hi;
+        }
+    }
+}
+
+#if defined(__SSE2__)
+// Converts 4 quantized coordinates to floats
+static inline __m128 dequantize(const uint8_t *q, __m128 origin, __m128 scale) {
+    int32_t packed;
+    std::memcpy(&packed, q, sizeof(packed));
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i v = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+    return _mm_add_ps(origin, _mm_mul_ps(_mm_cvtepi32_ps(v), scale));
+}
+#endif
+
+// Slab test of all children of a node, bit i of the result is set if child i is hit
+template <int N>
+unsigned WideBVH<N>::hit_mask(const Node &node, const float *o, const float *inv_d) const {
+    unsigned mask = 0;
+#if defined(__SSE2__)
+    for (int c = 0; c < N; c += 4) {
+        __m128 tmin = _mm_set1_ps(-INF);
+        __m128 tmax = _mm_set1_ps(INF);
+        for (int a = 0; a < 3; a++) {
+            const __m128 origin = _mm_set1_ps(node.origin[a]);
+            const __m128 scale = _mm_set1_ps(node.scale[a]);
+            const __m128 ro = _mm_set1_ps(o[a]);
+            const __m128 rd = _mm_set1_ps(inv_d[a]);
+            const __m128 t1 = _mm_mul_ps(_mm_sub_ps(dequantize(&node.lo[a][c], origin, scale), ro), rd);
+            const __m128 t2 = _mm_mul_ps(_mm_sub_ps(dequantize(&node.hi[a][c], origin, scale), ro), rd);
+            tmin = _mm_max_ps(tmin, _mm_min_ps(t1, t2));
+            tmax = _mm_min_ps(tmax, _mm_max_ps(t1, t2));
+        }
+        const __m128 hit = _mm_cmpgt_ps(tmax, _mm_max_ps(tmin, _mm_setzero_ps()));
+        mask |= (unsigned) _mm_movemask_ps(hit) << c;
+    }
+#else
+    for (int i = 0; i < N; i++) {
+        float tmin = -INF, tmax = INF;
+        for (int a = 0; a < 3; a++) {
+            const float t1 = (node.origin[a] + node.lo[a][i] * node.scale[a] - o[a]) * inv_d[a];
+            const float t2 = (node.origin[a] + node.hi[a][i] * node.scale[a] - o[a]) * inv_d[a];
+            tmin = std::max(tmin, std::min(t1, t2));
+            tmax = std::min(tmax, std::max(t1, t2));
+        }
+        if (tmax > std::max(tmin, 0.0f))
+            mask |= 1u << i;
+    }
+#endif
+    return mask & node.valid;
+}
+
+template <int N>
+void WideBVH<N>::intersect_node(int index, const Ray &r, const float *o, const float *inv_d, std::vector<Intersection> &xs) const {
+    STATS_NODE_VISIT();
+    const Node &node = nodes_[index];
+    const unsigned mask = hit_mask(node, o, inv_d);
+    for (int i = 0; i < N; i++) {
+        if (!(mask & (1u << i)))
+            continue;
+        if (node.child[i] >= 0) {
+            intersect_node(node.child[i], r, o, inv_d, xs);
+        } else {
+            const int32_t first = ~node.child[i];
+            for (int32_t k = first; k < first + node.count[i]; k++)
+                r.intersect(prims_[k], xs);
+        }
+    }
+}
+
+template <int N>
+void WideBVH<N>::intersect(const Ray &r, std::vector<Intersection> &xs) const {
+    if (!bounds.intersects(r))
+        return;
+
+    const size_t first = xs.size();
+    for (const auto &u : unbounded_)
+        r.intersect(u, xs);
+    if (!nodes_.empty()) {
+        const Tuple origin = r.get_origin();
+        const Tuple direction = r.get_direction();
+        const float o[3] = {origin[0], origin[1], origin[2]};
+        const float inv_d[3] = {1.0f / direction[0], 1.0f / direction[1], 1.0f / direction[2]};
+        intersect_node(0, r, o, inv_d, xs);
+    }
+    if (unique_hits_)
+        Group::remove_duplicates(xs, first);
+}
+
+template <int N>
+Tuple WideBVH<N>::normal_at_local(const Tuple &p, const Intersection &i) const {
+    throw std::runtime_error("A BVH does not have a normal vector!");
+}
+
+template <int N>
+bool WideBVH<N>::operator==(const Shape &rhs) const {
+    const WideBVH<N> *rhs_bvh = dynamic_cast<const WideBVH<N>*>(&rhs);
+    return rhs_bvh && rhs_bvh->prims_ == prims_ && rhs_bvh->unbounded_ == unbounded_ && Shape::operator==(rhs);
+}
+
+template <int N>
+bool WideBVH<N>::includes(const ShapePtr &s) const {
+    auto found = [&s](const ShapePtr &prim) { return prim == s || prim->includes(s); };
+    return std::any_of(prims_.begin(), prims_.end(), found) || std::any_of(unbounded_.begin(), unbounded_.end(), found);
+}
+
+template <int N>
+bool WideBVH<N>::is_aggregate() const {
+    return true;
+}
+
+// Refits the primitives and requantizes the nodes, the topology is kept
+template <int N>
+void WideBVH<N>::refit() {
+    for (const auto &prim : prims_)
+        prim->refit();
+    for (const auto &u : unbounded_)
+        u->refit();
+
+    // Children are always stored after their parent
+    std::vector<Bounds> node_boxes(nodes_.size());
+    for (int index = (int) nodes_.size() - 1; index >= 0; index--) {
+        Node &node = nodes_[index];
+        Bounds boxes[N];
+        for (int i = 0; i < N; i++) {
+            if (!(node.valid & (1u << i)))
+                continue;
+            if (node.child[i] >= 0) {
+                boxes[i] = node_boxes[node.child[i]];
+            } else {
+                const int32_t first = ~node.child[i];
+                for (int32_t k = first; k < first + node.count[i]; k++)
+                    boxes[i].merge(prims_[k]->bounds_transform);
+            }
+            node_boxes[index].merge(boxes[i]);
+        }
+        quantize(node, boxes, node_boxes[index]);
+    }
+
+    Bounds box = nodes_.empty() ? Bounds() : node_boxes[0];
+    for (const auto &u : unbounded_)
+        box.merge(u->bounds_transform);
+    bounds = box;
+    Shape::refit();
+}
+
+template <int N>
+size_t WideBVH<N>::n_nodes() const {
+    return nodes_.size();
+}
+
+template <int N>
+size_t WideBVH<N>::n_primitives() const {
+    return prims_.size() + unbounded_.size();
+}
+
+template class WideBVH<4>;
+template class WideBVH<8>;